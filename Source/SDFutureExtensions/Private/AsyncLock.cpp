@@ -0,0 +1,295 @@
+// Copyright(c) Splash Damage. All rights reserved.
+#include "AsyncLock.h"
+
+#include "FutureExtensionTaskGraph.h"
+#include "WaiterQueue.h"
+#include "HAL/CriticalSection.h"
+#include "Misc/ScopeLock.h"
+
+#include <atomic>
+
+namespace SD
+{
+	namespace Details
+	{
+		namespace
+		{
+			//The state word holds the number of free permits in its low half, and the number of queued waiters in its
+			//high half, so an acquire can check for both (and stay behind the queue) with a single compare and swap
+			constexpr uint64 OneWaiter = uint64(1) << 32;
+
+			uint32 GetNumFree(const uint64 StateWord)
+			{
+				return uint32(StateWord);
+			}
+
+			uint32 GetNumWaiters(const uint64 StateWord)
+			{
+				return uint32(StateWord >> 32);
+			}
+
+			//A writer takes every permit of an FAsyncRWLock
+			constexpr int32 MaxReaders = MAX_int32;
+		}
+
+		class FLockHold final : public FFutureAllocated
+		{
+		public:
+			FLockHold(const TSharedRef<FAsyncSemaphoreState, ESPMode::ThreadSafe>& InState, const int32 InNumPermits)
+				: State(InState)
+				, NumPermits(InNumPermits)
+				, RefCount(0)
+			{}
+
+			~FLockHold();
+
+			FLockHold(const FLockHold&) = delete;
+			FLockHold& operator=(const FLockHold&) = delete;
+
+			uint32 AddRef() const
+			{
+				return uint32(RefCount.fetch_add(1, std::memory_order_relaxed) + 1);
+			}
+
+			uint32 Release() const
+			{
+				const int32 NewRefCount = RefCount.fetch_sub(1, std::memory_order_acq_rel) - 1;
+				if (NewRefCount == 0)
+				{
+					delete this;
+				}
+				return uint32(NewRefCount);
+			}
+
+		private:
+			TSharedRef<FAsyncSemaphoreState, ESPMode::ThreadSafe> State;
+			const int32 NumPermits;
+			mutable std::atomic<int32> RefCount;
+		};
+
+		class FAsyncSemaphoreState : public TSharedFromThis<FAsyncSemaphoreState, ESPMode::ThreadSafe>
+		{
+		public:
+			explicit FAsyncSemaphoreState(const int32 NumPermits)
+				: StateWord(uint64(NumPermits))
+			{
+				check(NumPermits > 0);
+			}
+
+			TExpectedFuture<FLockGuard> Acquire(const int32 NumPermits, const FExpectedFutureOptions& Options)
+			{
+				uint64 Current = StateWord.load(std::memory_order_relaxed);
+				while (GetNumWaiters(Current) == 0 && GetNumFree(Current) >= uint32(NumPermits))
+				{
+					if (StateWord.compare_exchange_weak(Current, Current - NumPermits, std::memory_order_acquire, std::memory_order_relaxed))
+					{
+						return MakeReadyFuture<FLockGuard>(MakeGuard(NumPermits));
+					}
+				}
+
+				TRefCountPtr<FWaiter> Waiter;
+				TExpectedFuture<FLockGuard> Future;
+				{
+					FScopeLock Lock(&CriticalSection);
+
+					//Either takes the permits after all, or joins the queue, depending on which the state word allows
+					Current = StateWord.load(std::memory_order_relaxed);
+					bool bAcquired = false;
+					while (true)
+					{
+						bAcquired = GetNumWaiters(Current) == 0 && GetNumFree(Current) >= uint32(NumPermits);
+						const uint64 Desired = bAcquired ? Current - NumPermits : Current + OneWaiter;
+						if (StateWord.compare_exchange_weak(Current, Desired, std::memory_order_acquire, std::memory_order_relaxed))
+						{
+							break;
+						}
+					}
+
+					if (!bAcquired)
+					{
+						//Before anyone can hand it the lock, which moves its promise out
+						Waiter = new FWaiter(AsShared(), NumPermits);
+						Future = Waiter->Promise.GetFuture();
+						Waiters.PushBack(*Waiter);
+					}
+				}
+
+				if (!Waiter.IsValid())
+				{
+					return MakeReadyFuture<FLockGuard>(MakeGuard(NumPermits));
+				}
+
+				FutureExtensionTaskGraph::TryAddPromiseToCancellationHandle(Options.GetCancellationTokenHandle(), CancellablePromiseRef(Waiter.GetReference()));
+				return Future;
+			}
+
+			void Release(const int32 NumPermits)
+			{
+				uint64 Current = StateWord.load(std::memory_order_relaxed);
+				while (GetNumWaiters(Current) == 0)
+				{
+					if (StateWord.compare_exchange_weak(Current, Current + NumPermits, std::memory_order_release, std::memory_order_relaxed))
+					{
+						return;
+					}
+				}
+
+				TArray<TRefCountPtr<FWaiter>> Acquired;
+				{
+					FScopeLock Lock(&CriticalSection);
+					StateWord.fetch_add(NumPermits, std::memory_order_release);
+					HandOver(Acquired);
+				}
+				Complete(Acquired);
+			}
+
+		private:
+			class FWaiter final : public FCancellablePromise, public TWaiterQueueLink<FWaiter>
+			{
+			public:
+				FWaiter(const TSharedRef<FAsyncSemaphoreState, ESPMode::ThreadSafe>& InState, const int32 InNumPermits)
+					: State(InState)
+					, NumPermits(InNumPermits)
+				{}
+
+				const TWeakPtr<FAsyncSemaphoreState, ESPMode::ThreadSafe> State;
+				const int32 NumPermits;
+
+				//Moved out once it is handed the lock, so a cancellation handle still holding the waiter does not also
+				//hold on to the guard
+				TExpectedPromise<FLockGuard> Promise;
+				std::atomic<bool> bDone{ false };
+
+			protected:
+				//Taken out of the queue under the lock, so it is either cancelled or handed the lock, never both
+				virtual void Cancel() override
+				{
+					const TSharedPtr<FAsyncSemaphoreState, ESPMode::ThreadSafe> PinnedState = State.Pin();
+					if (PinnedState.IsValid() && PinnedState->Dequeue(*this))
+					{
+						bDone = true;
+						Promise.Cancel();
+					}
+				}
+
+				virtual bool IsSet() const override
+				{
+					return bDone;
+				}
+			};
+
+			FLockGuard MakeGuard(const int32 NumPermits)
+			{
+				return FLockGuard(new FLockHold(AsShared(), NumPermits));
+			}
+
+			bool Dequeue(FWaiter& Waiter)
+			{
+				TArray<TRefCountPtr<FWaiter>> Acquired;
+				{
+					FScopeLock Lock(&CriticalSection);
+					if (!Waiters.Remove(Waiter).IsValid())
+					{
+						return false;
+					}
+
+					//Whoever was queued behind it may fit in the permits it was waiting for
+					StateWord.fetch_sub(OneWaiter, std::memory_order_relaxed);
+					HandOver(Acquired);
+				}
+				Complete(Acquired);
+				return true;
+			}
+
+			//Only called under the lock. While there are waiters nothing else takes permits, so checking and then
+			//taking them does not need to be a single step.
+			void HandOver(TArray<TRefCountPtr<FWaiter>>& OutAcquired)
+			{
+				while (!Waiters.IsEmpty() && GetNumFree(StateWord.load(std::memory_order_relaxed)) >= uint32(Waiters.Front().NumPermits))
+				{
+					StateWord.fetch_sub(OneWaiter + Waiters.Front().NumPermits, std::memory_order_acquire);
+					OutAcquired.Add(Waiters.PopFront());
+				}
+			}
+
+			void Complete(const TArray<TRefCountPtr<FWaiter>>& Acquired)
+			{
+				for (const TRefCountPtr<FWaiter>& Waiter : Acquired)
+				{
+					TExpectedPromise<FLockGuard> Promise = MoveTemp(Waiter->Promise);
+					Waiter->bDone = true;
+					Promise.SetValue(MakeGuard(Waiter->NumPermits));
+				}
+			}
+
+			std::atomic<uint64> StateWord;
+
+			FCriticalSection CriticalSection;
+			TWaiterQueue<FWaiter> Waiters;
+		};
+
+		FLockHold::~FLockHold()
+		{
+			State->Release(NumPermits);
+		}
+	}
+}
+
+SD::FLockGuard::FLockGuard() = default;
+SD::FLockGuard::~FLockGuard() = default;
+SD::FLockGuard::FLockGuard(const FLockGuard& Other) = default;
+SD::FLockGuard::FLockGuard(FLockGuard&& Other) = default;
+SD::FLockGuard& SD::FLockGuard::operator=(const FLockGuard& Other) = default;
+SD::FLockGuard& SD::FLockGuard::operator=(FLockGuard&& Other) = default;
+
+SD::FLockGuard::FLockGuard(Details::FLockHold* InHold)
+	: Hold(InHold)
+{}
+
+void SD::FLockGuard::Release()
+{
+	Hold.SafeRelease();
+}
+
+bool SD::FLockGuard::IsValid() const
+{
+	return Hold.IsValid();
+}
+
+SD::FAsyncMutex::FAsyncMutex()
+	: State(MakeShared<Details::FAsyncSemaphoreState, ESPMode::ThreadSafe>(1))
+{}
+
+SD::FAsyncMutex::~FAsyncMutex() = default;
+
+SD::TExpectedFuture<SD::FLockGuard> SD::FAsyncMutex::Acquire(const FExpectedFutureOptions& Options)
+{
+	return State->Acquire(1, Options);
+}
+
+SD::FAsyncSemaphore::FAsyncSemaphore(const int32 NumPermits)
+	: State(MakeShared<Details::FAsyncSemaphoreState, ESPMode::ThreadSafe>(NumPermits))
+{}
+
+SD::FAsyncSemaphore::~FAsyncSemaphore() = default;
+
+SD::TExpectedFuture<SD::FLockGuard> SD::FAsyncSemaphore::Acquire(const FExpectedFutureOptions& Options)
+{
+	return State->Acquire(1, Options);
+}
+
+SD::FAsyncRWLock::FAsyncRWLock()
+	: State(MakeShared<Details::FAsyncSemaphoreState, ESPMode::ThreadSafe>(Details::MaxReaders))
+{}
+
+SD::FAsyncRWLock::~FAsyncRWLock() = default;
+
+SD::TExpectedFuture<SD::FLockGuard> SD::FAsyncRWLock::AcquireRead(const FExpectedFutureOptions& Options)
+{
+	return State->Acquire(1, Options);
+}
+
+SD::TExpectedFuture<SD::FLockGuard> SD::FAsyncRWLock::AcquireWrite(const FExpectedFutureOptions& Options)
+{
+	return State->Acquire(Details::MaxReaders, Options);
+}
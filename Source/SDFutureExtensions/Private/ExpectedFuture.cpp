@@ -0,0 +1,80 @@
+// Copyright(c) Splash Damage. All rights reserved.
+#include "ExpectedFuture.h"
+
+namespace SD
+{
+	namespace FutureExecutionDetails
+	{
+		namespace
+		{
+			struct FInlineContinuationQueue
+			{
+				int32 Depth = 0;
+				FExpectedFutureContinuation* Head = nullptr;
+				FExpectedFutureContinuation* Tail = nullptr;
+			};
+
+			thread_local FInlineContinuationQueue InlineContinuationQueue;
+		}
+
+		void FInlineContinuationExecutor::Execute(FExpectedFutureContinuation* Continuation)
+		{
+			FInlineContinuationQueue& Queue = InlineContinuationQueue;
+
+			if (Queue.Depth >= MaxDepth)
+			{
+				//Too deep - trampoline it back to the outermost Execute() on this thread
+				Continuation->NextContinuation = nullptr;
+				if (Queue.Tail != nullptr)
+				{
+					Queue.Tail->NextContinuation = Continuation;
+				}
+				else
+				{
+					Queue.Head = Continuation;
+				}
+				Queue.Tail = Continuation;
+				return;
+			}
+
+			++Queue.Depth;
+			Continuation->Execute();
+			Exit();
+		}
+
+		bool FInlineContinuationExecutor::TryEnter()
+		{
+			FInlineContinuationQueue& Queue = InlineContinuationQueue;
+
+			if (Queue.Depth >= MaxDepth)
+			{
+				return false;
+			}
+
+			++Queue.Depth;
+			return true;
+		}
+
+		void FInlineContinuationExecutor::Exit()
+		{
+			FInlineContinuationQueue& Queue = InlineContinuationQueue;
+
+			if (Queue.Depth == 1)
+			{
+				while (Queue.Head != nullptr)
+				{
+					FExpectedFutureContinuation* Deferred = Queue.Head;
+					Queue.Head = Deferred->NextContinuation;
+					if (Queue.Head == nullptr)
+					{
+						Queue.Tail = nullptr;
+					}
+
+					Deferred->NextContinuation = nullptr;
+					Deferred->Execute();
+				}
+			}
+			--Queue.Depth;
+		}
+	}
+}
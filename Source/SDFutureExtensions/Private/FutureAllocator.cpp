@@ -0,0 +1,195 @@
+// Copyright(c) Splash Damage. All rights reserved.
+#include "FutureAllocator.h"
+
+#include "Containers/LockFreeFixedSizeAllocator.h"
+
+#include <atomic>
+
+namespace SD
+{
+	namespace FutureAllocator
+	{
+		namespace
+		{
+			thread_local uint64 NumAllocationsOnThread = 0;
+
+#if SDFUTUREEXTENSIONS_ALLOCATOR_STATS
+			template<typename T>
+			void UpdateHighWaterMark(std::atomic<T>& HighWaterMark, const T Value)
+			{
+				T Current = HighWaterMark.load(std::memory_order_relaxed);
+				while (Value > Current && !HighWaterMark.compare_exchange_weak(Current, Value, std::memory_order_relaxed))
+				{
+				}
+			}
+
+			struct FCounters
+			{
+				std::atomic<int32> NumBlocksInUse{ 0 };
+				std::atomic<int32> HighWaterMark{ 0 };
+			};
+
+			std::atomic<int64> UnpooledBytesInUse{ 0 };
+			std::atomic<int64> UnpooledBytesHighWaterMark{ 0 };
+#endif
+
+#if SDFUTUREEXTENSIONS_POOLED_ALLOCATOR
+			/*
+			*	Each size class is a slab allocator with a thread-local cache of free blocks, which are handed back to
+			*	a global free list in bundles. Memory is never returned to the system, as the number of futures in
+			*	flight tends to stay around the same level.
+			*/
+			template<int32 BlockSize>
+			struct TSizeClass
+			{
+				using FAllocator = TLockFreeFixedSizeAllocator_TLSCache<BlockSize, PLATFORM_CACHE_LINE_SIZE>;
+
+				static FAllocator& GetAllocator()
+				{
+					//Deliberately leaked so futures released during static destruction can still be freed
+					static FAllocator* Allocator = new FAllocator();
+					return *Allocator;
+				}
+
+				static void* Allocate()
+				{
+					return GetAllocator().Allocate();
+				}
+
+				static void Free(void* Ptr)
+				{
+					GetAllocator().Free(Ptr);
+				}
+			};
+
+			struct FSizeClass
+			{
+				int32 BlockSize;
+				void* (*Allocate)();
+				void (*Free)(void*);
+			};
+
+			//Multiples of 16 so every block in a slab keeps the default alignment
+			const FSizeClass SizeClasses[] =
+			{
+				{ 32, &TSizeClass<32>::Allocate, &TSizeClass<32>::Free },
+				{ 64, &TSizeClass<64>::Allocate, &TSizeClass<64>::Free },
+				{ 96, &TSizeClass<96>::Allocate, &TSizeClass<96>::Free },
+				{ 128, &TSizeClass<128>::Allocate, &TSizeClass<128>::Free },
+				{ 192, &TSizeClass<192>::Allocate, &TSizeClass<192>::Free },
+				{ 256, &TSizeClass<256>::Allocate, &TSizeClass<256>::Free },
+				{ 384, &TSizeClass<384>::Allocate, &TSizeClass<384>::Free },
+				{ 512, &TSizeClass<512>::Allocate, &TSizeClass<512>::Free },
+			};
+
+			constexpr int32 NumSizeClasses = UE_ARRAY_COUNT(SizeClasses);
+			constexpr int32 InvalidSizeClass = INDEX_NONE;
+
+			int32 GetSizeClassIndex(const SIZE_T Size)
+			{
+				for (int32 Index = 0; Index < NumSizeClasses; ++Index)
+				{
+					if (Size <= static_cast<SIZE_T>(SizeClasses[Index].BlockSize))
+					{
+						return Index;
+					}
+				}
+				return InvalidSizeClass;
+			}
+
+	#if SDFUTUREEXTENSIONS_ALLOCATOR_STATS
+			FCounters SizeClassCounters[NumSizeClasses];
+	#endif
+#endif
+
+			void* UnpooledMalloc(const SIZE_T Size)
+			{
+#if SDFUTUREEXTENSIONS_ALLOCATOR_STATS
+				const int64 BytesInUse = UnpooledBytesInUse.fetch_add(Size, std::memory_order_relaxed) + Size;
+				UpdateHighWaterMark(UnpooledBytesHighWaterMark, BytesInUse);
+#endif
+				return FMemory::Malloc(Size);
+			}
+
+			void UnpooledFree(void* Ptr, const SIZE_T Size)
+			{
+#if SDFUTUREEXTENSIONS_ALLOCATOR_STATS
+				UnpooledBytesInUse.fetch_sub(Size, std::memory_order_relaxed);
+#endif
+				FMemory::Free(Ptr);
+			}
+		}
+
+		void* Malloc(SIZE_T Size)
+		{
+			++NumAllocationsOnThread;
+
+#if SDFUTUREEXTENSIONS_POOLED_ALLOCATOR
+			const int32 SizeClassIndex = GetSizeClassIndex(Size);
+			if (SizeClassIndex != InvalidSizeClass)
+			{
+	#if SDFUTUREEXTENSIONS_ALLOCATOR_STATS
+				FCounters& Counters = SizeClassCounters[SizeClassIndex];
+				const int32 NumBlocksInUse = Counters.NumBlocksInUse.fetch_add(1, std::memory_order_relaxed) + 1;
+				UpdateHighWaterMark(Counters.HighWaterMark, NumBlocksInUse);
+	#endif
+				return SizeClasses[SizeClassIndex].Allocate();
+			}
+#endif
+
+			return UnpooledMalloc(Size);
+		}
+
+		void Free(void* Ptr, SIZE_T Size)
+		{
+			if (!Ptr)
+			{
+				return;
+			}
+
+#if SDFUTUREEXTENSIONS_POOLED_ALLOCATOR
+			const int32 SizeClassIndex = GetSizeClassIndex(Size);
+			if (SizeClassIndex != InvalidSizeClass)
+			{
+	#if SDFUTUREEXTENSIONS_ALLOCATOR_STATS
+				SizeClassCounters[SizeClassIndex].NumBlocksInUse.fetch_sub(1, std::memory_order_relaxed);
+	#endif
+				SizeClasses[SizeClassIndex].Free(Ptr);
+				return;
+			}
+#endif
+
+			UnpooledFree(Ptr, Size);
+		}
+
+		uint64 GetNumAllocationsOnCurrentThread()
+		{
+			return NumAllocationsOnThread;
+		}
+
+		FStats GetStats()
+		{
+			FStats Stats;
+
+#if SDFUTUREEXTENSIONS_ALLOCATOR_STATS
+	#if SDFUTUREEXTENSIONS_POOLED_ALLOCATOR
+			for (int32 Index = 0; Index < NumSizeClasses; ++Index)
+			{
+				FPoolStats& PoolStats = Stats.Pools.AddDefaulted_GetRef();
+				PoolStats.BlockSize = SizeClasses[Index].BlockSize;
+				PoolStats.NumBlocksInUse = SizeClassCounters[Index].NumBlocksInUse.load(std::memory_order_relaxed);
+				PoolStats.HighWaterMark = SizeClassCounters[Index].HighWaterMark.load(std::memory_order_relaxed);
+
+				Stats.BytesInUse += static_cast<int64>(PoolStats.NumBlocksInUse) * PoolStats.BlockSize;
+			}
+	#endif
+
+			Stats.UnpooledBytesInUse = UnpooledBytesInUse.load(std::memory_order_relaxed);
+			Stats.UnpooledBytesHighWaterMark = UnpooledBytesHighWaterMark.load(std::memory_order_relaxed);
+			Stats.BytesInUse += Stats.UnpooledBytesInUse;
+#endif
+
+			return Stats;
+		}
+	}
+}
@@ -10,41 +10,25 @@ SD::TExpectedFuture<void> SD::WhenAll(const TArray<SD::TExpectedFuture<void>>& F
 		return SD::MakeReadyFuture();
 	}
 
-	const auto CounterRef = MakeShared<std::atomic<int32>, ESPMode::ThreadSafe>(Futures.Num());
-	const auto PromiseRef = MakeShared<SD::TExpectedPromise<void>, ESPMode::ThreadSafe>();
-	const auto FirstErrorRef = MakeShared<SD::TExpectedPromise<void>, ESPMode::ThreadSafe>();
-
-	const auto SetPromise = [FirstErrorRef, PromiseRef]()
-	{
-		FirstErrorRef->GetFuture().Then([PromiseRef](SD::TExpected<void> Result) {PromiseRef->SetValue(MoveTemp(Result)); });
-	};
-
-	if (FailMode == EFailMode::Fast)
-	{
-		SetPromise();
-	}
+	const auto State = MakeShared<Details::TWhenAllState<void>, ESPMode::ThreadSafe>(Futures.Num(), FailMode);
+	const FExpectedFutureOptions InlineOptions(EExpectedFutureExecutionPolicy::Inline);
 
 	for (const auto& Future : Futures)
 	{
-		Future.Then([CounterRef, FirstErrorRef, SetPromise, FailMode](const SD::TExpected<void>& Result)
+		Future.Then([State](SD::TExpected<void> Result)
 			{
 				if (Result.IsCompleted() == false)
 				{
-					FirstErrorRef->SetValue(SD::TExpected<void>(Result));
+					State->OnFailed(MoveTemp(Result));
 				}
 
-				if (--(CounterRef.Get()) == 0)
+				if (State->OnAntecedentDone())
 				{
-					FirstErrorRef->SetValue();
-
-					if (FailMode != EFailMode::Fast)
-					{
-						SetPromise();
-					}
+					State->Complete([]() { return MakeReadyExpected(); });
 				}
-			});
+			}, InlineOptions);
 	}
-	return PromiseRef->GetFuture();
+	return State->GetFuture();
 }
 
 SD::TExpectedFuture<void> SD::WhenAll(const TArray<TExpectedFuture<void>>& Futures)
@@ -52,18 +36,85 @@ SD::TExpectedFuture<void> SD::WhenAll(const TArray<TExpectedFuture<void>>& Futur
 	return WhenAll(Futures, EFailMode::Full);
 }
 
+namespace
+{
+	std::atomic<int64> NumHedgedRequests{ 0 };
+	std::atomic<int64> NumHedgesStarted{ 0 };
+	std::atomic<int64> NumHedgesWon{ 0 };
+}
+
+int32 SD::Details::FParallelChunking::GetNumWorkers(const FExpectedFutureOptions& Options)
+{
+	switch (Options.GetExecutionPolicy())
+	{
+	case EExpectedFutureExecutionPolicy::ThreadPool:
+		return GThreadPool ? FMath::Max(GThreadPool->GetNumThreads(), 1) : 1;
+	case EExpectedFutureExecutionPolicy::NamedThread:
+		return 1;
+	case EExpectedFutureExecutionPolicy::Current:
+	case EExpectedFutureExecutionPolicy::Inline:
+	default:
+		return FMath::Max(FTaskGraphInterface::Get().GetNumWorkerThreads(), 1);
+	}
+}
+
+int32 SD::Details::FParallelChunking::GetMaxPilotItems(const int32 NumItems, const int32 NumWorkers)
+{
+	return FMath::Max(NumItems / (NumWorkers * ChunksPerWorker), 1);
+}
+
+int32 SD::Details::FParallelChunking::GetChunkSize(const int32 NumItems, const int32 NumWorkers, const double SecondsPerItem)
+{
+	const int32 BalancedChunkSize = FMath::DivideAndRoundUp(NumItems, NumWorkers * ChunksPerWorker);
+	const int32 MinChunkSize = SecondsPerItem > 0.0
+		? static_cast<int32>(FMath::Min(FMath::CeilToDouble(MinChunkSeconds / SecondsPerItem), double(NumItems)))
+		: NumItems;
+
+	return FMath::Clamp(FMath::Max(BalancedChunkSize, MinChunkSize), 1, NumItems);
+}
+
 SD::TExpectedFuture<void> SD::WaitAsync(const float DelayInSeconds)
 {
-	const TSharedRef<TExpectedPromise<void>> Promise = MakeShared<TExpectedPromise<void>>();
+	TExpectedPromise<void> Promise;
 
 	FTSTicker::GetCoreTicker().AddTicker(
-		FTickerDelegate::CreateLambda([Promise](const float Delta)
+		FTickerDelegate::CreateLambda([Promise](const float Delta) mutable
 	{
-		Promise->SetValue();
+		Promise.SetValue();
 
 		// false = don't need to execute again
 		return false;
 	}), DelayInSeconds);
 
-	return Promise->GetFuture();
+	return Promise.GetFuture();
+}
+
+float SD::FRetryPolicy::GetDelaySeconds(const int32 NumFailedAttempts) const
+{
+	const float BackoffSeconds = FMath::Min(InitialDelaySeconds * FMath::Pow(BackoffMultiplier, float(NumFailedAttempts - 1)), MaxDelaySeconds);
+	return bFullJitter ? FMath::FRandRange(0.0f, BackoffSeconds) : BackoffSeconds;
+}
+
+SD::FHedgeStats SD::GetHedgeStats()
+{
+	FHedgeStats Stats;
+	Stats.NumRequests = NumHedgedRequests.load(std::memory_order_relaxed);
+	Stats.NumHedgesStarted = NumHedgesStarted.load(std::memory_order_relaxed);
+	Stats.NumHedgesWon = NumHedgesWon.load(std::memory_order_relaxed);
+	return Stats;
+}
+
+void SD::Details::FHedgeCounters::OnRequest()
+{
+	NumHedgedRequests.fetch_add(1, std::memory_order_relaxed);
+}
+
+void SD::Details::FHedgeCounters::OnHedgeStarted()
+{
+	NumHedgesStarted.fetch_add(1, std::memory_order_relaxed);
+}
+
+void SD::Details::FHedgeCounters::OnHedgeWon()
+{
+	NumHedgesWon.fetch_add(1, std::memory_order_relaxed);
 }
@@ -0,0 +1,100 @@
+// Copyright(c) Splash Damage. All rights reserved.
+#pragma once
+
+#include "ExpectedFuture.h"
+
+namespace SD
+{
+	namespace Details
+	{
+		class FAsyncSemaphoreState;
+		class FLockHold;
+	}
+
+	/*
+	*	Holds an async lock until it, and every copy of it, has been released or destroyed.
+	*	Copies share the one acquisition, so a guard can be passed on through continuations by value.
+	*/
+	class SDFUTUREEXTENSIONS_API FLockGuard
+	{
+	public:
+		FLockGuard();
+		~FLockGuard();
+
+		FLockGuard(const FLockGuard& Other);
+		FLockGuard(FLockGuard&& Other);
+		FLockGuard& operator=(const FLockGuard& Other);
+		FLockGuard& operator=(FLockGuard&& Other);
+
+		//Lets go of this copy's share of the lock
+		void Release();
+
+		bool IsValid() const;
+
+	private:
+		friend class Details::FAsyncSemaphoreState;
+
+		explicit FLockGuard(Details::FLockHold* InHold);
+
+		TRefCountPtr<Details::FLockHold> Hold;
+	};
+
+	/*
+	*	Async locks are acquired through a future rather than by blocking, so a continuation waiting for one never ties
+	*	up a worker thread. An uncontended Acquire() is a single compare and swap and returns a ready future.
+	*
+	*	Waiters are queued in FIFO order, and a release hands the lock straight to the next one: its promise is set on
+	*	the releasing thread, with no task scheduled in between. Cancelling the handle in a waiter's options takes it
+	*	out of the queue.
+	*/
+	class SDFUTUREEXTENSIONS_API FAsyncMutex
+	{
+	public:
+		FAsyncMutex();
+		~FAsyncMutex();
+
+		FAsyncMutex(const FAsyncMutex&) = delete;
+		FAsyncMutex& operator=(const FAsyncMutex&) = delete;
+
+		TExpectedFuture<FLockGuard> Acquire(const FExpectedFutureOptions& Options = FExpectedFutureOptions());
+
+	private:
+		TSharedRef<Details::FAsyncSemaphoreState, ESPMode::ThreadSafe> State;
+	};
+
+	//Lets up to NumPermits guards hold it at once, see FAsyncMutex
+	class SDFUTUREEXTENSIONS_API FAsyncSemaphore
+	{
+	public:
+		explicit FAsyncSemaphore(const int32 NumPermits);
+		~FAsyncSemaphore();
+
+		FAsyncSemaphore(const FAsyncSemaphore&) = delete;
+		FAsyncSemaphore& operator=(const FAsyncSemaphore&) = delete;
+
+		TExpectedFuture<FLockGuard> Acquire(const FExpectedFutureOptions& Options = FExpectedFutureOptions());
+
+	private:
+		TSharedRef<Details::FAsyncSemaphoreState, ESPMode::ThreadSafe> State;
+	};
+
+	/*
+	*	Any number of readers, or a single writer, see FAsyncMutex.
+	*	Readers and writers share one FIFO queue, so readers that arrive after a waiting writer wait behind it.
+	*/
+	class SDFUTUREEXTENSIONS_API FAsyncRWLock
+	{
+	public:
+		FAsyncRWLock();
+		~FAsyncRWLock();
+
+		FAsyncRWLock(const FAsyncRWLock&) = delete;
+		FAsyncRWLock& operator=(const FAsyncRWLock&) = delete;
+
+		TExpectedFuture<FLockGuard> AcquireRead(const FExpectedFutureOptions& Options = FExpectedFutureOptions());
+		TExpectedFuture<FLockGuard> AcquireWrite(const FExpectedFutureOptions& Options = FExpectedFutureOptions());
+
+	private:
+		TSharedRef<Details::FAsyncSemaphoreState, ESPMode::ThreadSafe> State;
+	};
+}
@@ -1,42 +1,120 @@
 // Copyright(c) Splash Damage. All rights reserved.
 #pragma once
 
+#include <atomic>
+
 #include "Templates/SharedPointer.h"
+#include "Templates/RefCounting.h"
 #include "Misc/ScopeLock.h"
+#include "FutureAllocator.h"
 
 namespace SD
 {
 	class FCancellationHandle;
 
-	class FCancellablePromise : public TSharedFromThis<FCancellablePromise, ESPMode::ThreadSafe>
+	using WeakSharedCancellationHandlePtr = TWeakPtr<FCancellationHandle, ESPMode::ThreadSafe>;
+	using SharedCancellationHandleRef = TSharedRef<FCancellationHandle, ESPMode::ThreadSafe>;
+	using SharedCancellationHandlePtr = TSharedPtr<FCancellationHandle, ESPMode::ThreadSafe>;
+
+	/*
+	*	Base for anything that can be cancelled through an FCancellationHandle.
+	*
+	*	Intrusively reference counted so the promise state can be the cancellable object itself, without a separate
+	*	shared pointer control block.
+	*/
+	class FCancellablePromise : public FFutureAllocated
 	{
 		friend class FCancellationHandle;
 
 	public:
-		virtual ~FCancellablePromise() {}
+		FCancellablePromise()
+			: RefCount(0)
+		{}
+
+		virtual ~FCancellablePromise();
+
+		FCancellablePromise(const FCancellablePromise&) = delete;
+		FCancellablePromise& operator=(const FCancellablePromise&) = delete;
+
+		uint32 AddRef() const
+		{
+			return uint32(RefCount.fetch_add(1, std::memory_order_relaxed) + 1);
+		}
+
+		uint32 Release() const
+		{
+			const int32 NewRefCount = RefCount.fetch_sub(1, std::memory_order_acq_rel) - 1;
+			if (NewRefCount == 0)
+			{
+				delete this;
+			}
+			return uint32(NewRefCount);
+		}
+
+		uint32 GetRefCount() const
+		{
+			return uint32(RefCount.load(std::memory_order_acquire));
+		}
 
 	protected:
 		virtual void Cancel() = 0;
-	};
+		virtual bool IsSet() const = 0;
 
-	using WeakSharedCancellablePromisePtr = TWeakPtr<FCancellablePromise, ESPMode::ThreadSafe>;
-	using SharedCancellablePromiseRef = TSharedRef<FCancellablePromise, ESPMode::ThreadSafe>;
-	using SharedCancellablePromisePtr = TSharedPtr<FCancellablePromise, ESPMode::ThreadSafe>;
+	private:
+		//Only succeeds while something else still holds a reference, so a handle can tell a live promise from one
+		//that is already being destroyed
+		bool TryAddRef() const
+		{
+			int32 Current = RefCount.load(std::memory_order_relaxed);
+			while (Current > 0)
+			{
+				if (RefCount.compare_exchange_weak(Current, Current + 1, std::memory_order_acquire, std::memory_order_relaxed))
+				{
+					return true;
+				}
+			}
+			return false;
+		}
 
-	using WeakSharedCancellationHandlePtr = TWeakPtr<FCancellationHandle, ESPMode::ThreadSafe>;
-	using SharedCancellationHandleRef = TSharedRef<FCancellationHandle, ESPMode::ThreadSafe>;
-	using SharedCancellationHandlePtr = TSharedPtr<FCancellationHandle, ESPMode::ThreadSafe>;
+		mutable std::atomic<int32> RefCount;
+
+		//The handle that tracks this promise without owning it. Set and cleared under that handle's lock.
+		std::atomic<bool> bTracked{ false };
+		WeakSharedCancellationHandlePtr TrackingHandle;
+		int32 TrackingIndex = INDEX_NONE;
+	};
+
+	using CancellablePromiseRef = TRefCountPtr<FCancellablePromise>;
 
 	class FCancellationHandle : public TSharedFromThis<FCancellationHandle, ESPMode::ThreadSafe>
 	{
+		friend class FCancellablePromise;
+
 	public:
-		inline void AddPromise(const SharedCancellablePromiseRef& Promise)
+		inline void AddPromise(const CancellablePromiseRef& Promise)
 		{
 			FScopeLock Lock(&PromisesLock);
 
 			if(!bCancelled)
 			{
-				PromisesToCancel.Push(WeakSharedCancellablePromisePtr(Promise));
+				//Promises are tracked without a reference, and take themselves out of the handle when they are
+				//destroyed, so a handle never keeps a finished promise or its value alive
+				if (!Promise->bTracked.exchange(true))
+				{
+					Promise->TrackingHandle = AsShared();
+					Promise->TrackingIndex = TrackedPromises.Add(Promise.GetReference());
+					return;
+				}
+
+				//Already tracked by another handle, so this one has to hold it. Periodically drop the ones that have
+				//been set; the threshold grows so this stays amortised O(1).
+				if (SharedPromises.Num() >= PruneThreshold)
+				{
+					SharedPromises.RemoveAllSwap([](const CancellablePromiseRef& Pending) { return Pending->IsSet(); });
+					PruneThreshold = FMath::Max(MinPruneThreshold, SharedPromises.Num() * 2);
+				}
+
+				SharedPromises.Push(Promise);
 			}
 			else
 			{
@@ -46,26 +124,67 @@ namespace SD
 
 		inline void Cancel()
 		{
-			FScopeLock Lock(&PromisesLock);
-			bCancelled = true;
-
-			for (auto& WeakPromise : PromisesToCancel)
+			TArray<CancellablePromiseRef> PromisesToCancel;
 			{
-				if (SharedCancellablePromisePtr Promise = WeakPromise.Pin())
+				FScopeLock Lock(&PromisesLock);
+				bCancelled = true;
+
+				PromisesToCancel.Reserve(TrackedPromises.Num() + SharedPromises.Num());
+				for (FCancellablePromise* Promise : TrackedPromises)
 				{
-					Promise->Cancel();
+					Promise->TrackingIndex = INDEX_NONE;
+					if (Promise->TryAddRef())
+					{
+						PromisesToCancel.Emplace(Promise, false);
+					}
 				}
+				PromisesToCancel.Append(MoveTemp(SharedPromises));
+
+				TrackedPromises.Empty();
+				SharedPromises.Empty();
 			}
 
-			PromisesToCancel.Empty();
+			//Outside of the lock, as the last reference to a promise may go with it
+			for (const CancellablePromiseRef& Promise : PromisesToCancel)
+			{
+				Promise->Cancel();
+			}
 		}
 
 	private:
+		void RemovePromise(FCancellablePromise& Promise)
+		{
+			FScopeLock Lock(&PromisesLock);
+
+			const int32 Index = Promise.TrackingIndex;
+			if (Index != INDEX_NONE)
+			{
+				TrackedPromises.RemoveAtSwap(Index, 1, false);
+				if (Index < TrackedPromises.Num())
+				{
+					TrackedPromises[Index]->TrackingIndex = Index;
+				}
+				Promise.TrackingIndex = INDEX_NONE;
+			}
+		}
+
+		static constexpr int32 MinPruneThreshold = 16;
+
 		FCriticalSection PromisesLock;
-		TArray<WeakSharedCancellablePromisePtr> PromisesToCancel;
+		TArray<FCancellablePromise*> TrackedPromises;
+		TArray<CancellablePromiseRef> SharedPromises;
+		int32 PruneThreshold = MinPruneThreshold;
 		bool bCancelled = false;
 	};
 
+	inline FCancellablePromise::~FCancellablePromise()
+	{
+		if (const SharedCancellationHandlePtr CancellationHandle = TrackingHandle.Pin())
+		{
+			CancellationHandle->RemovePromise(*this);
+		}
+	}
+
 	inline SharedCancellationHandleRef CreateCancellationHandle()
 	{
 		return MakeShared<FCancellationHandle, ESPMode::ThreadSafe>();
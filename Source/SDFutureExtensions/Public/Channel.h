@@ -0,0 +1,460 @@
+// Copyright(c) Splash Damage. All rights reserved.
+#pragma once
+
+#include "ExpectedFuture.h"
+#include "FutureExtensionTaskGraph.h"
+#include "HAL/CriticalSection.h"
+#include "Misc/Optional.h"
+#include "Misc/ScopeLock.h"
+#include "WaiterQueue.h"
+
+#include <atomic>
+
+namespace SD
+{
+	namespace Details
+	{
+		/*
+		*	Bounded lock-free ring buffer for any number of producers and consumers.
+		*
+		*	Each cell's sequence says whose turn it is: Position * 2 once it is free for the value at that position,
+		*	and Position * 2 + 1 once it holds it. Doubling keeps the two states apart with a capacity of 1.
+		*/
+		template<typename T>
+		class TChannelRing
+		{
+		public:
+			explicit TChannelRing(const int32 InCapacity)
+				: Capacity(uint64(InCapacity))
+				, Cells(new FCell[InCapacity])
+			{
+				check(InCapacity > 0);
+				for (uint64 Index = 0; Index < Capacity; ++Index)
+				{
+					Cells[Index].Sequence.store(Index * 2, std::memory_order_relaxed);
+				}
+			}
+
+			~TChannelRing()
+			{
+				delete[] Cells;
+			}
+
+			TChannelRing(const TChannelRing&) = delete;
+			TChannelRing& operator=(const TChannelRing&) = delete;
+
+			//Only moves from Value if there was room for it
+			bool TryPush(T& Value)
+			{
+				uint64 Position = EnqueuePosition.load(std::memory_order_relaxed);
+				while (true)
+				{
+					FCell& Cell = Cells[Position % Capacity];
+					const int64 Difference = int64(Cell.Sequence.load(std::memory_order_acquire)) - int64(Position * 2);
+					if (Difference == 0)
+					{
+						if (EnqueuePosition.compare_exchange_weak(Position, Position + 1, std::memory_order_relaxed))
+						{
+							Cell.Value.Emplace(MoveTemp(Value));
+							Cell.Sequence.store(Position * 2 + 1, std::memory_order_release);
+							return true;
+						}
+					}
+					else if (Difference < 0)
+					{
+						//Still holds the value from the previous lap, so the ring is full
+						return false;
+					}
+					else
+					{
+						Position = EnqueuePosition.load(std::memory_order_relaxed);
+					}
+				}
+			}
+
+			bool TryPop(TOptional<T>& OutValue)
+			{
+				uint64 Position = DequeuePosition.load(std::memory_order_relaxed);
+				while (true)
+				{
+					FCell& Cell = Cells[Position % Capacity];
+					const int64 Difference = int64(Cell.Sequence.load(std::memory_order_acquire)) - int64(Position * 2 + 1);
+					if (Difference == 0)
+					{
+						if (DequeuePosition.compare_exchange_weak(Position, Position + 1, std::memory_order_relaxed))
+						{
+							OutValue.Emplace(MoveTemp(Cell.Value.GetValue()));
+							Cell.Value.Reset();
+							Cell.Sequence.store((Position + Capacity) * 2, std::memory_order_release);
+							return true;
+						}
+					}
+					else if (Difference < 0)
+					{
+						//Nothing has been written here yet, so the ring is empty
+						return false;
+					}
+					else
+					{
+						Position = DequeuePosition.load(std::memory_order_relaxed);
+					}
+				}
+			}
+
+		private:
+			struct FCell
+			{
+				std::atomic<uint64> Sequence;
+				TOptional<T> Value;
+			};
+
+			const uint64 Capacity;
+			FCell* const Cells;
+
+			//Producers and consumers each have their own cache line
+			alignas(PLATFORM_CACHE_LINE_SIZE) std::atomic<uint64> EnqueuePosition{ 0 };
+			alignas(PLATFORM_CACHE_LINE_SIZE) std::atomic<uint64> DequeuePosition{ 0 };
+		};
+
+		/*
+		*	Sends and receives go straight through the ring while they can. Only those that have to wait take the lock,
+		*	to queue up, and they are counted so the other side knows to hand over to them once it gets through.
+		*/
+		template<typename T>
+		class TChannelState : public TSharedFromThis<TChannelState<T>, ESPMode::ThreadSafe>
+		{
+		public:
+			explicit TChannelState(const int32 Capacity)
+				: Ring(Capacity)
+			{}
+
+			TExpectedFuture<void> Send(T&& Value, const FExpectedFutureOptions& Options)
+			{
+				if (bClosed.load(std::memory_order_acquire))
+				{
+					return MakeReadyFuture<void>(MakeCancelledExpected());
+				}
+
+				//Queued senders go first, so a send can only take a free slot straight away while nobody is waiting for one
+				if (NumWaitingSenders.load(std::memory_order_acquire) > 0 || !Ring.TryPush(Value))
+				{
+					TRefCountPtr<FSendWaiter> Waiter;
+					{
+						FScopeLock Lock(&CriticalSection);
+						if (bClosed.load(std::memory_order_relaxed))
+						{
+							return MakeReadyFuture<void>(MakeCancelledExpected());
+						}
+
+						NumWaitingSenders.fetch_add(1);
+						std::atomic_thread_fence(std::memory_order_seq_cst);
+						if (SendWaiters.IsEmpty() && Ring.TryPush(Value))
+						{
+							NumWaitingSenders.fetch_sub(1);
+						}
+						else
+						{
+							Waiter = new FSendWaiter(this->AsShared(), MoveTemp(Value));
+							SendWaiters.PushBack(*Waiter);
+						}
+					}
+
+					if (Waiter.IsValid())
+					{
+						FutureExtensionTaskGraph::TryAddPromiseToCancellationHandle(Options.GetCancellationTokenHandle(), CancellablePromiseRef(Waiter.GetReference()));
+						return CompleteOn(Waiter->Promise.GetFuture(), Options);
+					}
+				}
+
+				HandOverIfWaiting(NumWaitingReceivers);
+				return MakeReadyFuture();
+			}
+
+			TExpectedFuture<T> Receive(const FExpectedFutureOptions& Options)
+			{
+				TOptional<T> Value;
+				if (!Ring.TryPop(Value))
+				{
+					TRefCountPtr<FReceiveWaiter> Waiter;
+					{
+						FScopeLock Lock(&CriticalSection);
+						NumWaitingReceivers.fetch_add(1);
+						std::atomic_thread_fence(std::memory_order_seq_cst);
+						if (Ring.TryPop(Value))
+						{
+							NumWaitingReceivers.fetch_sub(1);
+						}
+						else if (bClosed.load(std::memory_order_relaxed))
+						{
+							NumWaitingReceivers.fetch_sub(1);
+							return MakeReadyFuture<T>(MakeCancelledExpected<T>());
+						}
+						else
+						{
+							Waiter = new FReceiveWaiter(this->AsShared());
+							ReceiveWaiters.PushBack(*Waiter);
+						}
+					}
+
+					if (Waiter.IsValid())
+					{
+						FutureExtensionTaskGraph::TryAddPromiseToCancellationHandle(Options.GetCancellationTokenHandle(), CancellablePromiseRef(Waiter.GetReference()));
+						return CompleteOn(Waiter->Promise.GetFuture(), Options);
+					}
+				}
+
+				HandOverIfWaiting(NumWaitingSenders);
+				return MakeReadyFuture<T>(MoveTemp(Value.GetValue()));
+			}
+
+			void Close()
+			{
+				TArray<TRefCountPtr<FReceiveWaiter>> Receivers;
+				TArray<TRefCountPtr<FSendWaiter>> Senders;
+				{
+					FScopeLock Lock(&CriticalSection);
+					if (bClosed.load(std::memory_order_relaxed))
+					{
+						return;
+					}
+
+					bClosed.store(true, std::memory_order_release);
+					while (!ReceiveWaiters.IsEmpty())
+					{
+						Receivers.Add(ReceiveWaiters.PopFront());
+					}
+					while (!SendWaiters.IsEmpty())
+					{
+						Senders.Add(SendWaiters.PopFront());
+					}
+					NumWaitingReceivers.fetch_sub(Receivers.Num());
+					NumWaitingSenders.fetch_sub(Senders.Num());
+				}
+
+				for (const TRefCountPtr<FReceiveWaiter>& Receiver : Receivers)
+				{
+					Receiver->Promise.Cancel();
+				}
+				for (const TRefCountPtr<FSendWaiter>& Sender : Senders)
+				{
+					Sender->Promise.Cancel();
+				}
+			}
+
+			bool IsClosed() const
+			{
+				return bClosed.load(std::memory_order_acquire);
+			}
+
+		private:
+			template<typename WaiterType>
+			class TWaiter : public FCancellablePromise, public TWaiterQueueLink<WaiterType>
+			{
+			public:
+				explicit TWaiter(const TSharedRef<TChannelState, ESPMode::ThreadSafe>& InState)
+					: State(InState)
+				{}
+
+			protected:
+				//Taken out of the queue under the channel's lock, so it is either cancelled or handed a value, never both
+				virtual void Cancel() override
+				{
+					WaiterType* Waiter = static_cast<WaiterType*>(this);
+					const TSharedPtr<TChannelState, ESPMode::ThreadSafe> PinnedState = State.Pin();
+					if (!PinnedState.IsValid() || PinnedState->Dequeue(*Waiter))
+					{
+						Waiter->Promise.Cancel();
+					}
+				}
+
+				virtual bool IsSet() const override
+				{
+					return static_cast<const WaiterType*>(this)->Promise.IsSet();
+				}
+
+			private:
+				TWeakPtr<TChannelState, ESPMode::ThreadSafe> State;
+			};
+
+			struct FReceiveWaiter final : public TWaiter<FReceiveWaiter>
+			{
+				using TWaiter<FReceiveWaiter>::TWaiter;
+
+				TOptional<T> Value;
+				TExpectedPromise<T> Promise;
+			};
+
+			struct FSendWaiter final : public TWaiter<FSendWaiter>
+			{
+				FSendWaiter(const TSharedRef<TChannelState, ESPMode::ThreadSafe>& InState, T&& InValue)
+					: TWaiter<FSendWaiter>(InState)
+				{
+					Value.Emplace(MoveTemp(InValue));
+				}
+
+				TOptional<T> Value;
+				TExpectedPromise<void> Promise;
+			};
+
+			//Only waiters that get as far as waiting pay for the hop to the thread their options ask for
+			template<typename R>
+			static TExpectedFuture<R> CompleteOn(TExpectedFuture<R>&& Future, const FExpectedFutureOptions& Options)
+			{
+				if (Options.GetExecutionPolicy() == EExpectedFutureExecutionPolicy::Inline)
+				{
+					return MoveTemp(Future);
+				}
+
+				//Without the cancellation handle, which has already been given the waiter
+				FExpectedFutureOptionsBuilder Builder;
+				if (Options.GetExecutionPolicy() == EExpectedFutureExecutionPolicy::NamedThread)
+				{
+					Builder.SetDesiredExecutionThread(Options.GetDesiredExecutionThread());
+				}
+				else
+				{
+					Builder.SetExecutionPolicy(Options.GetExecutionPolicy());
+				}
+
+				return Future.Then([](TExpected<R> Result)
+				{
+					return Result;
+				}, Builder.Build());
+			}
+
+			bool Dequeue(FReceiveWaiter& Waiter)
+			{
+				FScopeLock Lock(&CriticalSection);
+				if (!ReceiveWaiters.Remove(Waiter).IsValid())
+				{
+					return false;
+				}
+
+				NumWaitingReceivers.fetch_sub(1);
+				return true;
+			}
+
+			bool Dequeue(FSendWaiter& Waiter)
+			{
+				FScopeLock Lock(&CriticalSection);
+				if (!SendWaiters.Remove(Waiter).IsValid())
+				{
+					return false;
+				}
+
+				NumWaitingSenders.fetch_sub(1);
+				return true;
+			}
+
+			//Pairs with the fence taken before a waiter's last try, so either it gets through or it is seen here
+			void HandOverIfWaiting(const std::atomic<int32>& NumWaiting)
+			{
+				std::atomic_thread_fence(std::memory_order_seq_cst);
+				if (NumWaiting.load(std::memory_order_relaxed) > 0)
+				{
+					HandOver();
+				}
+			}
+
+			void HandOver()
+			{
+				TArray<TRefCountPtr<FReceiveWaiter>> Received;
+				TArray<TRefCountPtr<FSendWaiter>> Sent;
+				{
+					FScopeLock Lock(&CriticalSection);
+					bool bHandedOver = true;
+					while (bHandedOver)
+					{
+						bHandedOver = false;
+
+						while (!SendWaiters.IsEmpty() && Ring.TryPush(SendWaiters.Front().Value.GetValue()))
+						{
+							Sent.Add(SendWaiters.PopFront());
+							NumWaitingSenders.fetch_sub(1);
+							bHandedOver = true;
+						}
+
+						while (!ReceiveWaiters.IsEmpty() && Ring.TryPop(ReceiveWaiters.Front().Value))
+						{
+							Received.Add(ReceiveWaiters.PopFront());
+							NumWaitingReceivers.fetch_sub(1);
+							bHandedOver = true;
+						}
+					}
+				}
+
+				for (const TRefCountPtr<FSendWaiter>& Sender : Sent)
+				{
+					Sender->Promise.SetValue();
+				}
+				for (const TRefCountPtr<FReceiveWaiter>& Receiver : Received)
+				{
+					Receiver->Promise.SetValue(MoveTemp(Receiver->Value.GetValue()));
+				}
+			}
+
+			TChannelRing<T> Ring;
+			std::atomic<bool> bClosed{ false };
+
+			//Including those still making their last try under the lock
+			std::atomic<int32> NumWaitingSenders{ 0 };
+			std::atomic<int32> NumWaitingReceivers{ 0 };
+
+			FCriticalSection CriticalSection;
+			TWaiterQueue<FReceiveWaiter> ReceiveWaiters;
+			TWaiterQueue<FSendWaiter> SendWaiters;
+		};
+	}
+
+	/*
+	*	Bounded channel for passing values between any number of senders and receivers, in the order they are sent.
+	*
+	*	Send() completes once the value is in the channel, straight away while there is room for it, and Receive()
+	*	completes with the next value, straight away if there is one. Either only allocates a promise when it has to
+	*	wait, and a waiting Send or Receive completes on the thread given by its options' execution policy (Inline
+	*	completes it on the thread that made room or sent the value). Cancelling the handle in its options takes it
+	*	out of the queue.
+	*
+	*	Once closed, or destroyed, waiting and later sends are cancelled. Receives still get the values already in the
+	*	channel, and are cancelled after that.
+	*/
+	template<typename T>
+	class TChannel
+	{
+	public:
+		explicit TChannel(const int32 Capacity)
+			: State(MakeShared<Details::TChannelState<T>, ESPMode::ThreadSafe>(Capacity))
+		{}
+
+		~TChannel()
+		{
+			State->Close();
+		}
+
+		TChannel(const TChannel&) = delete;
+		TChannel& operator=(const TChannel&) = delete;
+
+		TExpectedFuture<void> Send(T Value, const FExpectedFutureOptions& Options = FExpectedFutureOptions())
+		{
+			return State->Send(MoveTemp(Value), Options);
+		}
+
+		TExpectedFuture<T> Receive(const FExpectedFutureOptions& Options = FExpectedFutureOptions())
+		{
+			return State->Receive(Options);
+		}
+
+		void Close()
+		{
+			State->Close();
+		}
+
+		bool IsClosed() const
+		{
+			return State->IsClosed();
+		}
+
+	private:
+		TSharedRef<Details::TChannelState<T>, ESPMode::ThreadSafe> State;
+	};
+}
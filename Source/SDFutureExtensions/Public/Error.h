@@ -2,6 +2,12 @@
 #pragma once
 
 #include "Templates/SharedPointer.h"
+#include "HAL/CriticalSection.h"
+#include "Misc/ScopeLock.h"
+#include "UObject/NameTypes.h"
+
+#include <atomic>
+#include <type_traits>
 
 namespace SD
 {
@@ -9,8 +15,76 @@ namespace SD
 	{
 		constexpr int32 ERROR_INVALID_ARGUMENT = 1;
 		constexpr int32 ERROR_OBJECT_DESTROYED = 2;
+		constexpr int32 ERROR_TIMED_OUT = 3;
+	}
+
+	namespace Details
+	{
+		/*
+		*	Shared storage for error info that is not known at compile time. Created with MakeShared so the string (or
+		*	the formatter that produces it) lives in the same allocation as the reference count.
+		*/
+		class FErrorInfoSource
+		{
+		public:
+			virtual ~FErrorInfoSource() = default;
+			virtual const FString& GetString() = 0;
+		};
+
+		class FErrorInfoString final : public FErrorInfoSource
+		{
+		public:
+			explicit FErrorInfoString(FString&& InString)
+				: String(MoveTemp(InString))
+			{}
+
+			virtual const FString& GetString() override
+			{
+				return String;
+			}
+
+		private:
+			FString String;
+		};
+
+		//Runs the formatter the first time the string is read, which may happen from any thread
+		template<typename FormatterType>
+		class TErrorInfoFormatter final : public FErrorInfoSource
+		{
+		public:
+			explicit TErrorInfoFormatter(FormatterType&& InFormatter)
+				: Formatter(MoveTemp(InFormatter))
+			{}
+
+			virtual const FString& GetString() override
+			{
+				if (!bFormatted.load(std::memory_order_acquire))
+				{
+					FScopeLock Lock(&FormatCriticalSection);
+					if (!bFormatted.load(std::memory_order_relaxed))
+					{
+						String = Formatter();
+						bFormatted.store(true, std::memory_order_release);
+					}
+				}
+				return String;
+			}
+
+		private:
+			FormatterType Formatter;
+			FString String;
+			FCriticalSection FormatCriticalSection;
+			std::atomic<bool> bFormatted{ false };
+		};
 	}
 
+	/*
+	*	Error info can come from:
+	*	- a string literal, stored as a pointer without allocating (see Error::Static)
+	*	- an FName, stored without allocating
+	*	- an FString, moved into a single shared allocation
+	*	- a formatter (see Error::Lazy), only invoked if the info is actually read
+	*/
 	class Error
 	{
 	public:
@@ -25,17 +99,67 @@ namespace SD
 			, ErrorContext(InErrorContext)
 		{}
 
-		Error(int32 InErrorCode, FString InErrorInfo)
+		//Only chosen for actual FNames, so raw TCHAR pointers keep converting to FString
+		template<typename NameType, typename = typename TEnableIf<std::is_same<NameType, FName>::value>::Type>
+		Error(int32 InErrorCode, NameType InErrorInfo)
+			: Error(InErrorCode, 0, InErrorInfo)
+		{}
+
+		template<typename NameType, typename = typename TEnableIf<std::is_same<NameType, FName>::value>::Type>
+		Error(int32 InErrorCode, int32 InErrorContext, NameType InErrorInfo)
 			: ErrorCode(InErrorCode)
-			, ErrorInfo(MakeShareable(new FString(InErrorInfo)))
+			, ErrorContext(InErrorContext)
+			, NameErrorInfo(InErrorInfo)
+		{}
+
+		Error(int32 InErrorCode, FString InErrorInfo)
+			: Error(InErrorCode, 0, MoveTemp(InErrorInfo))
 		{}
 
 		Error(int32 InErrorCode, int32 InErrorContext, FString InErrorInfo)
 			: ErrorCode(InErrorCode)
 			, ErrorContext(InErrorContext)
-			, ErrorInfo(MakeShareable(new FString(InErrorInfo)))
+			, ErrorInfoSource(MakeShared<Details::FErrorInfoString, ESPMode::ThreadSafe>(MoveTemp(InErrorInfo)))
 		{}
 
+		/*
+		*	Keeps a pointer to the error info instead of copying it, so it must have static storage, e.g. a TEXT()
+		*	literal. Any other TCHAR array or pointer goes through the FString constructors and is copied.
+		*/
+		template<SIZE_T N>
+		static Error Static(int32 InErrorCode, int32 InErrorContext, const TCHAR(&InErrorInfo)[N])
+		{
+			Error Result(InErrorCode, InErrorContext);
+			Result.StaticErrorInfo = InErrorInfo;
+			return Result;
+		}
+
+		template<SIZE_T N>
+		static Error Static(int32 InErrorCode, const TCHAR(&InErrorInfo)[N])
+		{
+			return Static(InErrorCode, 0, InErrorInfo);
+		}
+
+		/*
+		*	Defers building the error info until it is read, for messages that are expensive to format and usually
+		*	only end up being checked by error code. The formatter must return an FString and may run on any thread.
+		*/
+		template<typename FormatterType>
+		static Error Lazy(int32 InErrorCode, int32 InErrorContext, FormatterType&& Formatter)
+		{
+			using FFormatter = Details::TErrorInfoFormatter<std::decay_t<FormatterType>>;
+
+			Error Result(InErrorCode, InErrorContext);
+			Result.ErrorInfoSource = MakeShared<FFormatter, ESPMode::ThreadSafe>(std::decay_t<FormatterType>(Forward<FormatterType>(Formatter)));
+			return Result;
+		}
+
+		template<typename FormatterType>
+		static Error Lazy(int32 InErrorCode, FormatterType&& Formatter)
+		{
+			return Lazy(InErrorCode, 0, Forward<FormatterType>(Formatter));
+		}
+
 		int32 GetErrorCode() const
 		{
 			return ErrorCode;
@@ -46,19 +170,56 @@ namespace SD
 			return ErrorContext;
 		}
 
+		bool HasErrorInfo() const
+		{
+			return StaticErrorInfo || !NameErrorInfo.IsNone() || ErrorInfoSource.IsValid();
+		}
+
+		//Only allocates for literal and FName info, which are not stored as an FString
 		const ErrorStringPtr GetErrorInfo() const
 		{
-			return ErrorInfo;
+			if (ErrorInfoSource.IsValid())
+			{
+				//Shares ownership with the source, so the string stays alive as long as the returned pointer
+				return ErrorStringPtr(ErrorInfoSource, const_cast<FString*>(&ErrorInfoSource->GetString()));
+			}
+			if (StaticErrorInfo || !NameErrorInfo.IsNone())
+			{
+				return MakeShared<FString, ESPMode::ThreadSafe>(GetErrorInfoString());
+			}
+			return nullptr;
 		}
 
 		ErrorStringPtr GetErrorInfo()
 		{
-			return ErrorInfo;
+			return static_cast<const Error*>(this)->GetErrorInfo();
+		}
+
+		//Empty if there is no error info
+		FString GetErrorInfoString() const
+		{
+			if (ErrorInfoSource.IsValid())
+			{
+				return ErrorInfoSource->GetString();
+			}
+			if (StaticErrorInfo)
+			{
+				return FString(StaticErrorInfo);
+			}
+			if (!NameErrorInfo.IsNone())
+			{
+				return NameErrorInfo.ToString();
+			}
+			return FString();
 		}
 
 	private:
 		int32 ErrorCode = 0;
 		int32 ErrorContext = 0;
-		ErrorStringPtr ErrorInfo = nullptr;
+
+		//At most one of these is set
+		const TCHAR* StaticErrorInfo = nullptr;
+		FName NameErrorInfo;
+		TSharedPtr<Details::FErrorInfoSource, ESPMode::ThreadSafe> ErrorInfoSource;
 	};
-}
\ No newline at end of file
+}
@@ -1,6 +1,8 @@
 // Copyright(c) Splash Damage. All rights reserved.
 #pragma once
 
+#include <atomic>
+
 #include "Async/Future.h"
 #include "FutureExtensionsTypeTraits.h"
 #include "Templates/AreTypesEqual.h"
@@ -8,6 +10,7 @@
 #include "Misc/QueuedThreadPool.h"
 #include "ExpectedResult.h"
 #include "ExpectedFutureOptions.h"
+#include "FutureAllocator.h"
 
 namespace SD
 {
@@ -24,6 +27,11 @@ namespace SD
 	template<>
 	class TExpectedPromise<void>;
 
+	namespace FutureExecutionDetails
+	{
+		class FInlineContinuationExecutor;
+	}
+
 	namespace FutureExtensionTaskGraph
 	{
 		template<typename F, typename R>
@@ -87,7 +95,9 @@ namespace SD
 		{
 			if (FutureOptions.GetExecutionPolicy() == EExpectedFutureExecutionPolicy::Inline)
 			{
-				return AntecedentFuture.GetExecutionDetails();
+				//Inline continuations are never dispatched, the thread is only kept so later continuations can inspect it
+				return FExecutionDetails(EExpectedFutureExecutionPolicy::Inline,
+					AntecedentFuture.GetExecutionDetails().ExecutionThread);
 			}
 			else
 			{
@@ -96,19 +106,172 @@ namespace SD
 		}
 	}
 
+	/*
+	*	A continuation waiting on a TExpectedPromiseState.
+	*
+	*	Continuations are stored in an intrusive, lock-free list owned by the state. Schedule() is called exactly once:
+	*	either by SetValue() on the thread that set the value, or straight away by AddContinuation() if the value was
+	*	already set. After Schedule() has been called the continuation is responsible for its own lifetime.
+	*/
+	class FExpectedFutureContinuation : public FFutureAllocated
+	{
+		friend class FExpectedFutureContinuationList;
+		friend class FutureExecutionDetails::FInlineContinuationExecutor;
+
+	public:
+		virtual ~FExpectedFutureContinuation() {}
+
+		virtual void Schedule() = 0;
+
+		//Runs the continuation on the calling thread and destroys it.
+		virtual void Execute() = 0;
+
+	private:
+		FExpectedFutureContinuation* NextContinuation = nullptr;
+	};
+
+	class FExpectedFutureContinuationList
+	{
+	public:
+		FExpectedFutureContinuationList()
+			: Head(nullptr)
+		{}
+
+		FExpectedFutureContinuationList(const FExpectedFutureContinuationList&) = delete;
+		FExpectedFutureContinuationList& operator=(const FExpectedFutureContinuationList&) = delete;
+
+		//Returns false if the list has already been closed, in which case the caller keeps ownership of the continuation.
+		bool TryAdd(FExpectedFutureContinuation* Continuation)
+		{
+			FExpectedFutureContinuation* CurrentHead = Head.load(std::memory_order_acquire);
+			do
+			{
+				if (CurrentHead == GetClosedMarker())
+				{
+					return false;
+				}
+				Continuation->NextContinuation = CurrentHead;
+			}
+			while (!Head.compare_exchange_weak(CurrentHead, Continuation, std::memory_order_acq_rel, std::memory_order_acquire));
+
+			return true;
+		}
+
+		//Closes an empty list that has not been shared yet, for states that are created already set.
+		void CloseEmpty()
+		{
+			check(Head.load(std::memory_order_relaxed) == nullptr);
+			Head.store(GetClosedMarker(), std::memory_order_relaxed);
+		}
+
+		//Closes the list to further additions and schedules every pending continuation in the order they were added.
+		void CloseAndSchedule()
+		{
+			FExpectedFutureContinuation* Pending = Head.exchange(GetClosedMarker(), std::memory_order_acq_rel);
+			check(Pending != GetClosedMarker());
+
+			//The list is built LIFO, reverse it so continuations run in the order they were attached
+			FExpectedFutureContinuation* Ordered = nullptr;
+			while (Pending != nullptr)
+			{
+				FExpectedFutureContinuation* Next = Pending->NextContinuation;
+				Pending->NextContinuation = Ordered;
+				Ordered = Pending;
+				Pending = Next;
+			}
+
+			while (Ordered != nullptr)
+			{
+				//Read the link before scheduling as the continuation may be destroyed by Schedule()
+				FExpectedFutureContinuation* Next = Ordered->NextContinuation;
+				Ordered->NextContinuation = nullptr;
+				Ordered->Schedule();
+				Ordered = Next;
+			}
+		}
+
+	private:
+		static FExpectedFutureContinuation* GetClosedMarker()
+		{
+			//Never dereferenced, only compared against, so this stays valid across module boundaries.
+			return reinterpret_cast<FExpectedFutureContinuation*>(UPTRINT(1));
+		}
+
+		std::atomic<FExpectedFutureContinuation*> Head;
+	};
+
+	//Fires a graph event when the promise is set, for anyone that needs to block on or interop with the task graph.
+	class FExpectedFutureGraphEventContinuation final : public FExpectedFutureContinuation
+	{
+	public:
+		explicit FExpectedFutureGraphEventContinuation(const FGraphEventRef& InEvent)
+			: Event(InEvent)
+		{}
+
+		virtual void Schedule() override
+		{
+			Execute();
+		}
+
+		virtual void Execute() override
+		{
+			Event->DispatchSubsequents();
+			delete this;
+		}
+
+	private:
+		FGraphEventRef Event;
+	};
+
+	namespace FutureExecutionDetails
+	{
+		/*
+		*	Runs EExpectedFutureExecutionPolicy::Inline continuations synchronously on the calling thread.
+		*
+		*	Inline continuations that set their own promise run their inline continuations in turn, so a long chain would
+		*	otherwise recurse once per link. Past MaxDepth nested continuations are queued instead and run, still on this
+		*	thread, by the outermost Execute() once the current one unwinds.
+		*/
+		class SDFUTUREEXTENSIONS_API FInlineContinuationExecutor
+		{
+		public:
+			static constexpr int32 MaxDepth = 32;
+
+			static void Execute(FExpectedFutureContinuation* Continuation);
+
+			//For a continuation the caller runs itself, without allocating it. Returns false past MaxDepth, in which
+			//case it has to go through Execute() instead. Every successful TryEnter() must be matched by an Exit().
+			static bool TryEnter();
+			static void Exit();
+		};
+	}
+
+	/*
+	*	The state shared between a TExpectedPromise and its TExpectedFutures.
+	*
+	*	A single intrusively reference counted allocation per promise: promises and futures are just references to it,
+	*	and it is also the object registered with an FCancellationHandle.
+	*/
 	template<typename ResultType>
-	class TExpectedPromiseState
+	class TExpectedPromiseState final : public FCancellablePromise
 	{
 	public:
 		TExpectedPromiseState(FutureExecutionDetails::FExecutionDetails InExecutionDetails)
-			: CompletionEvent(TGraphTask<FNullGraphTask>::CreateTask()
-				.ConstructAndHold(TStatId(), ENamedThreads::AnyThread)->GetCompletionEvent())
-			, ValueSetSync(0)
+			: ValueSetSync(0)
 			, ExecutionDetails(MoveTemp(InExecutionDetails))
 		{
 		}
 
-		~TExpectedPromiseState()
+		//Creates a state that is already set, so there is nothing to trigger and continuations are scheduled on arrival
+		TExpectedPromiseState(FutureExecutionDetails::FExecutionDetails InExecutionDetails, TExpected<ResultType>&& InValue)
+			: ValueSetSync(2)
+			, ExecutionDetails(MoveTemp(InExecutionDetails))
+			, Value(MoveTemp(InValue))
+		{
+			Continuations.CloseEmpty();
+		}
+
+		virtual ~TExpectedPromiseState()
 		{
 			// If we're shutting down, the system may no longer exist
 			// so skip this in that case to prevent a crash
@@ -145,28 +308,78 @@ namespace SD
 			return Value;
 		}
 
+		//Only valid once set. Must only be modified by a future that holds the single future reference.
+		TExpected<ResultType>& GetValueRef()
+		{
+			check(IsSet());
+			return Value;
+		}
+
+		//Futures, and promises that can still hand out futures, are counted separately from other references, as they
+		//are the only ones that can read the value.
+		void AddReaderRef()
+		{
+			NumReaderRefs.fetch_add(1, std::memory_order_relaxed);
+		}
+
+		void ReleaseReaderRef()
+		{
+			NumReaderRefs.fetch_sub(1, std::memory_order_release);
+		}
+
+		bool HasSingleReaderRef() const
+		{
+			return NumReaderRefs.load(std::memory_order_acquire) == 1;
+		}
+
 		FutureExecutionDetails::FExecutionDetails GetExecutionDetails() const
 		{
 			return ExecutionDetails;
 		}
 
-		bool IsSet() const
+		virtual bool IsSet() const override
 		{
 			return FPlatformAtomics::AtomicRead(&ValueSetSync) == 2;
 		}
 
-		FGraphEventRef GetCompletionEvent() const
+		virtual void Cancel() override
 		{
+			SetValue(SD::MakeCancelledExpected<ResultType>());
+		}
+
+		//Takes ownership of the continuation. It is scheduled when the value is set, or immediately if it already is.
+		void AddContinuation(FExpectedFutureContinuation* Continuation)
+		{
+			if (!Continuations.TryAdd(Continuation))
+			{
+				Continuation->Schedule();
+			}
+		}
+
+		//Graph events are only created on request (e.g. to Wait()), so continuations don't pay for one.
+		FGraphEventRef GetCompletionEvent()
+		{
+			FGraphEventRef CompletionEvent = FGraphEvent::CreateGraphEvent();
+			if (IsSet())
+			{
+				CompletionEvent->DispatchSubsequents();
+			}
+			else
+			{
+				AddContinuation(new FExpectedFutureGraphEventContinuation(CompletionEvent));
+			}
 			return CompletionEvent;
 		}
 
 	private:
 		void Trigger()
 		{
-			CompletionEvent->DispatchSubsequents();
+			Continuations.CloseAndSchedule();
 		}
 
-		FGraphEventRef CompletionEvent;
+		FExpectedFutureContinuationList Continuations;
+
+		std::atomic<int32> NumReaderRefs{ 0 };
 
 		// By design, cancellation and valid value setting is a race - cancellation is always *best attempt*.
 		// Trying to set a promise value that's already been set *should* just fail silently
@@ -177,6 +390,178 @@ namespace SD
 		TExpected<ResultType> Value;
 	};
 
+	/*
+	*	A future's reference to its state. Besides keeping the state alive, it counts the futures that can read the value
+	*	so that when only one is left, its continuation can take the value by move instead of copying it.
+	*/
+	template<typename ResultType>
+	class TExpectedFutureStateRef
+	{
+	public:
+		TExpectedFutureStateRef() = default;
+
+		explicit TExpectedFutureStateRef(const TRefCountPtr<TExpectedPromiseState<ResultType>>& InState)
+			: State(InState)
+		{
+			AddFutureRef();
+		}
+
+		TExpectedFutureStateRef(const TExpectedFutureStateRef& Other)
+			: State(Other.State)
+		{
+			AddFutureRef();
+		}
+
+		TExpectedFutureStateRef(TExpectedFutureStateRef&& Other)
+			: State(MoveTemp(Other.State))
+		{
+		}
+
+		~TExpectedFutureStateRef()
+		{
+			ReleaseFutureRef();
+		}
+
+		TExpectedFutureStateRef& operator=(const TExpectedFutureStateRef& Other)
+		{
+			TExpectedFutureStateRef Copy(Other);
+			return *this = MoveTemp(Copy);
+		}
+
+		TExpectedFutureStateRef& operator=(TExpectedFutureStateRef&& Other)
+		{
+			if (this != &Other)
+			{
+				ReleaseFutureRef();
+				State = MoveTemp(Other.State);
+			}
+			return *this;
+		}
+
+		bool IsValid() const
+		{
+			return State.IsValid();
+		}
+
+		TExpectedPromiseState<ResultType>* operator->() const
+		{
+			return State.GetReference();
+		}
+
+	private:
+		void AddFutureRef()
+		{
+			if (State.IsValid())
+			{
+				State->AddReaderRef();
+			}
+		}
+
+		void ReleaseFutureRef()
+		{
+			if (State.IsValid())
+			{
+				State->ReleaseReaderRef();
+			}
+		}
+
+		TRefCountPtr<TExpectedPromiseState<ResultType>> State;
+	};
+
+	/*
+	*	A promise's reference to its state. Until the promise is made write-only, it counts as a reader along with the
+	*	futures, as it can still hand out more of them.
+	*/
+	template<typename ResultType>
+	class TExpectedPromiseStateRef
+	{
+	public:
+		explicit TExpectedPromiseStateRef(TExpectedPromiseState<ResultType>* InState)
+			: State(InState)
+		{
+			AddReaderRef();
+		}
+
+		TExpectedPromiseStateRef(const TExpectedPromiseStateRef& Other)
+			: State(Other.State)
+			, bWriteOnly(Other.bWriteOnly)
+		{
+			AddReaderRef();
+		}
+
+		TExpectedPromiseStateRef(TExpectedPromiseStateRef&& Other)
+			: State(MoveTemp(Other.State))
+			, bWriteOnly(Other.bWriteOnly)
+		{
+		}
+
+		~TExpectedPromiseStateRef()
+		{
+			ReleaseReaderRef();
+		}
+
+		TExpectedPromiseStateRef& operator=(const TExpectedPromiseStateRef& Other)
+		{
+			TExpectedPromiseStateRef Copy(Other);
+			return *this = MoveTemp(Copy);
+		}
+
+		TExpectedPromiseStateRef& operator=(TExpectedPromiseStateRef&& Other)
+		{
+			if (this != &Other)
+			{
+				ReleaseReaderRef();
+				State = MoveTemp(Other.State);
+				bWriteOnly = Other.bWriteOnly;
+			}
+			return *this;
+		}
+
+		const TRefCountPtr<TExpectedPromiseState<ResultType>>& GetState() const
+		{
+			return State;
+		}
+
+		TExpectedPromiseState<ResultType>* operator->() const
+		{
+			return State.GetReference();
+		}
+
+		void SetWriteOnly()
+		{
+			if (!bWriteOnly)
+			{
+				ReleaseReaderRef();
+				bWriteOnly = true;
+			}
+		}
+
+		bool IsWriteOnly() const
+		{
+			return bWriteOnly;
+		}
+
+	private:
+		void AddReaderRef()
+		{
+			if (State.IsValid() && !bWriteOnly)
+			{
+				State->AddReaderRef();
+			}
+		}
+
+		void ReleaseReaderRef()
+		{
+			if (State.IsValid() && !bWriteOnly)
+			{
+				State->ReleaseReaderRef();
+			}
+		}
+
+		TRefCountPtr<TExpectedPromiseState<ResultType>> State;
+		bool bWriteOnly = false;
+	};
+
 	namespace FutureInitialisationDetails
 	{
 		using namespace FutureExtensionTypeTraits;
@@ -187,25 +572,23 @@ namespace SD
 			using InitialFunctorTypes = TInitialFunctorTypes<F>;
 
 			using UnwrappedReturnType = typename TUnwrap<typename InitialFunctorTypes::ReturnType>::Type;
-			using SharedPromiseRef = TSharedRef<TExpectedPromise<UnwrappedReturnType>, ESPMode::ThreadSafe>;
 
 			const FutureExecutionDetails::FExecutionDetails ExecutionDetails =
 					FutureExecutionDetails::GetExecutionDetails(FutureOptions);
 
-			SharedPromiseRef Promise =
-				MakeShared<TExpectedPromise<UnwrappedReturnType>, ESPMode::ThreadSafe>(ExecutionDetails);
-			TExpectedFuture<UnwrappedReturnType> Future = Promise->GetFuture();
+			TExpectedPromise<UnwrappedReturnType> Promise(ExecutionDetails);
+			TExpectedFuture<UnwrappedReturnType> Future = Promise.GetFuture();
 
 			if (ExecutionDetails.ExecutionPolicy == EExpectedFutureExecutionPolicy::ThreadPool)
 			{
 				using InitWorkType = FutureExtensionTaskGraph::TExpectedFutureInitQueuedWork<F, UnwrappedReturnType>;
-				GThreadPool->AddQueuedWork(new InitWorkType(Forward<F>(Function), Promise, FutureOptions.GetCancellationTokenHandle()));
+				GThreadPool->AddQueuedWork(new InitWorkType(Forward<F>(Function), MoveTemp(Promise), FutureOptions.GetCancellationTokenHandle()));
 			}
 			else
 			{
 				using InitTaskType = FutureExtensionTaskGraph::TExpectedFutureInitTask<F, UnwrappedReturnType>;
 				TGraphTask<InitTaskType>::CreateTask()
-					.ConstructAndDispatchWhenReady(Forward<F>(Function), Promise, FutureOptions.GetCancellationTokenHandle());
+					.ConstructAndDispatchWhenReady(Forward<F>(Function), MoveTemp(Promise), FutureOptions.GetCancellationTokenHandle());
 			}
 
 			return Future;
@@ -288,7 +671,7 @@ namespace SD
 		using namespace FutureExtensionTypeTraits;
 
 		template<class F, class P, typename LifetimeMonitorType>
-		auto ThenImpl(F&& Func, const TExpectedFuture<P>& PrevFuture, FGraphEventRef ContinuationTrigger,
+		auto ThenImpl(F&& Func, const TExpectedFuture<P>& PrevFuture,
 						const SD::FExpectedFutureOptions& FutureOptions, LifetimeMonitorType LifetimeMonitor)
 		{
 			check(PrevFuture.IsValid());
@@ -296,33 +679,47 @@ namespace SD
 			using ContinuationFunctorTypes = TContinuationFunctorTypes<F, P>;
 
 			using UnwrappedReturnType = typename TUnwrap<typename ContinuationFunctorTypes::ReturnType>::Type;
-			using SharedPromiseRef = TSharedRef<TExpectedPromise<UnwrappedReturnType>, ESPMode::ThreadSafe>;
 
 			const FutureExecutionDetails::FExecutionDetails ExecutionDetails =
 					FutureExecutionDetails::GetExecutionDetails(FutureOptions, PrevFuture);
 
-			SharedPromiseRef Promise = MakeShared<TExpectedPromise<UnwrappedReturnType>, ESPMode::ThreadSafe>(ExecutionDetails);
-			TExpectedFuture<UnwrappedReturnType> Future = Promise->GetFuture();
+			TExpectedPromise<UnwrappedReturnType> Promise(ExecutionDetails);
+			TExpectedFuture<UnwrappedReturnType> Future = Promise.GetFuture();
+
+			using ContinuationTaskType = FutureExtensionTaskGraph::TExpectedFutureContinuationTask<F, P, UnwrappedReturnType, LifetimeMonitorType>;
 
 			if (ExecutionDetails.ExecutionPolicy == EExpectedFutureExecutionPolicy::ThreadPool)
 			{
 				using ContinuationWorkType = FutureExtensionTaskGraph::TExpectedFutureContinuationQueuedWork<F, P, UnwrappedReturnType, LifetimeMonitorType>;
-				GThreadPool->AddQueuedWork(new ContinuationWorkType(Forward<F>(Func),
+				PrevFuture.AddContinuation(new ContinuationWorkType(Forward<F>(Func),
 																	MoveTemp(Promise),
 																	PrevFuture,
 																	FutureOptions.GetCancellationTokenHandle(),
 																	MoveTemp(LifetimeMonitor)));
 			}
+			else if (ExecutionDetails.ExecutionPolicy == EExpectedFutureExecutionPolicy::Inline && PrevFuture.IsReady()
+					&& FutureExecutionDetails::FInlineContinuationExecutor::TryEnter())
+			{
+				//Nothing to wait on, so run the continuation right here instead of allocating it. Past the depth limit
+				//it is allocated below instead, and trampolined like any other inline continuation.
+				{
+					ContinuationTaskType Continuation(Forward<F>(Func),
+														MoveTemp(Promise),
+														PrevFuture,
+														FutureOptions.GetCancellationTokenHandle(),
+														MoveTemp(LifetimeMonitor));
+					Continuation.DoTask(ENamedThreads::AnyThread, FGraphEventRef());
+				}
+				FutureExecutionDetails::FInlineContinuationExecutor::Exit();
+			}
 			else
 			{
-				using ContinuationTaskType = FutureExtensionTaskGraph::TExpectedFutureContinuationTask<F, P, UnwrappedReturnType, LifetimeMonitorType>;
-				FGraphEventArray TriggerArray{ ContinuationTrigger };
-				TGraphTask<ContinuationTaskType>::CreateTask(&TriggerArray)
-					.ConstructAndDispatchWhenReady(Forward<F>(Func),
-													MoveTemp(Promise),
-													PrevFuture,
-													FutureOptions.GetCancellationTokenHandle(),
-													MoveTemp(LifetimeMonitor));
+				//A ready antecedent schedules the continuation straight away
+				PrevFuture.AddContinuation(new ContinuationTaskType(Forward<F>(Func),
+																	MoveTemp(Promise),
+																	PrevFuture,
+																	FutureOptions.GetCancellationTokenHandle(),
+																	MoveTemp(LifetimeMonitor)));
 			}
 
 			return Future;
@@ -337,7 +734,7 @@ namespace SD
 		using UnwrappedResultType = typename FutureExtensionTypeTraits::TUnwrap<R>::Type;
 		using ExpectedResultType = TExpected<UnwrappedResultType>;
 
-		TExpectedFuture(const TSharedRef<TExpectedPromiseState<ResultType>, ESPMode::ThreadSafe>& InPreviousPromise)
+		TExpectedFuture(const TRefCountPtr<TExpectedPromiseState<ResultType>>& InPreviousPromise)
 			: PreviousPromise(InPreviousPromise)
 		{}
 
@@ -376,7 +773,7 @@ namespace SD
 		{
 			check(IsValid());
 			return FutureContinuationDetails::ThenImpl(Forward<F>(Func), *this,
-														PreviousPromise->GetCompletionEvent(), FutureOptions, FutureContinuationDetails::TLifetimeMonitor<void>());
+														FutureOptions, FutureContinuationDetails::TLifetimeMonitor<void>());
 		}
 
 		template<class F, typename TOwnerType>
@@ -384,7 +781,7 @@ namespace SD
 		{
 			check(IsValid());
 			return FutureContinuationDetails::ThenImpl(Forward<F>(Func), *this,
-														PreviousPromise->GetCompletionEvent(), FutureOptions, FutureContinuationDetails::TLifetimeMonitor<TOwnerType>(Owner));
+														FutureOptions, FutureContinuationDetails::TLifetimeMonitor<TOwnerType>(Owner));
 		}
 
 		bool IsReady() const
@@ -411,25 +808,40 @@ namespace SD
 
 		void Wait() const
 		{
-			if (PreviousPromise)
+			if (IsValid() && !PreviousPromise->IsSet())
 			{
 				PreviousPromise->GetCompletionEvent()->Wait();
 			}
 		}
 
+		void AddContinuation(FExpectedFutureContinuation* Continuation) const
+		{
+			check(IsValid());
+			PreviousPromise->AddContinuation(Continuation);
+		}
+
+		//For continuations: the value without a copy. bOutCanMove is set if no other future can read it, and no promise
+		//can hand out one that would, in which case the caller may move from it.
+		TExpected<ResultType>& GetValueForContinuation(bool& bOutCanMove) const
+		{
+			check(IsReady());
+			bOutCanMove = PreviousPromise->HasSingleReaderRef();
+			return PreviousPromise->GetValueRef();
+		}
+
 	private:
-		TSharedPtr<TExpectedPromiseState<ResultType>, ESPMode::ThreadSafe> PreviousPromise;
+		TExpectedFutureStateRef<ResultType> PreviousPromise;
 	};
 
 	template <class R>
-	class TExpectedPromise : public FCancellablePromise
+	class TExpectedPromise
 	{
 		using ExpectedResultType = TExpected<R>;
 
 	public:
 		TExpectedPromise(const FutureExecutionDetails::FExecutionDetails& InExecutionDetails =
 							FutureExecutionDetails::FExecutionDetails())
-			: State(MakeShared<TExpectedPromiseState<R>, ESPMode::ThreadSafe>(InExecutionDetails))
+			: State(new TExpectedPromiseState<R>(InExecutionDetails))
 		{
 		}
 
@@ -440,7 +852,18 @@ namespace SD
 
 		TExpectedFuture<R> GetFuture()
 		{
-			return TExpectedFuture<R>(State);
+			checkf(!State.IsWriteOnly(), TEXT("Called GetFuture() on a write-only TExpectedPromise"));
+			return TExpectedFuture<R>(State.GetState());
+		}
+
+		/*
+		*	Gives up taking futures from this promise, and from copies made of it from now on. Until then the promise
+		*	could hand out a future that reads the value later, so continuations have to copy the value rather than
+		*	move it out of the state.
+		*/
+		void SetWriteOnly()
+		{
+			State.SetWriteOnly();
 		}
 
 		bool IsSet() const
@@ -455,7 +878,7 @@ namespace SD
 
 		void SetValue(ExpectedResultType&& Result)
 		{
-			State->SetValue(Result);
+			State->SetValue(MoveTemp(Result));
 		}
 
 		void SetValue(R&& Result)
@@ -475,11 +898,17 @@ namespace SD
 
 		void Cancel()
 		{
-			SetValue(SD::MakeCancelledExpected<R>());
+			State->Cancel();
+		}
+
+		//The shared state is the cancellable object, so this is what gets registered with an FCancellationHandle
+		CancellablePromiseRef GetCancellablePromise() const
+		{
+			return CancellablePromiseRef(State.GetState().GetReference());
 		}
 
 	private:
-		TSharedRef<TExpectedPromiseState<R>, ESPMode::ThreadSafe> State;
+		TExpectedPromiseStateRef<R> State;
 	};
 
 	template <>
@@ -489,7 +918,7 @@ namespace SD
 		using ResultType = void;
 		using ExpectedResultType = TExpected<void>;
 
-		TExpectedFuture(const TSharedRef<TExpectedPromiseState<void>, ESPMode::ThreadSafe>& InPreviousPromise)
+		TExpectedFuture(const TRefCountPtr<TExpectedPromiseState<void>>& InPreviousPromise)
 			: PreviousPromise(InPreviousPromise)
 		{}
 
@@ -532,7 +961,7 @@ namespace SD
 		{
 			check(IsValid());
 			return FutureContinuationDetails::ThenImpl(Forward<F>(Func), *this,
-														PreviousPromise->GetCompletionEvent(), FutureOptions, FutureContinuationDetails::TLifetimeMonitor<void>());
+														FutureOptions, FutureContinuationDetails::TLifetimeMonitor<void>());
 		}
 
 		template<class F, typename TOwnerType>
@@ -540,7 +969,7 @@ namespace SD
 		{
 			check(IsValid());
 			return FutureContinuationDetails::ThenImpl(Forward<F>(Func), *this,
-														PreviousPromise->GetCompletionEvent(), FutureOptions, FutureContinuationDetails::TLifetimeMonitor<TOwnerType>(Owner));
+														FutureOptions, FutureContinuationDetails::TLifetimeMonitor<TOwnerType>(Owner));
 		}
 
 		ExpectedResultType Get() const
@@ -562,18 +991,33 @@ namespace SD
 
 		void Wait() const
 		{
-			if (PreviousPromise)
+			if (IsValid() && !PreviousPromise->IsSet())
 			{
 				PreviousPromise->GetCompletionEvent()->Wait();
 			}
 		}
 
+		void AddContinuation(FExpectedFutureContinuation* Continuation) const
+		{
+			check(IsValid());
+			PreviousPromise->AddContinuation(Continuation);
+		}
+
+		//For continuations: the value without a copy. bOutCanMove is set if no other future can read it, and no promise
+		//can hand out one that would, in which case the caller may move from it.
+		TExpected<ResultType>& GetValueForContinuation(bool& bOutCanMove) const
+		{
+			check(IsReady());
+			bOutCanMove = PreviousPromise->HasSingleReaderRef();
+			return PreviousPromise->GetValueRef();
+		}
+
 	private:
-		TSharedPtr<TExpectedPromiseState<void>, ESPMode::ThreadSafe> PreviousPromise;
+		TExpectedFutureStateRef<void> PreviousPromise;
 	};
 
 	template<>
-	class TExpectedPromise<void> : public FCancellablePromise
+	class TExpectedPromise<void>
 	{
 	public:
 
@@ -581,7 +1025,7 @@ namespace SD
 
 		TExpectedPromise(const FutureExecutionDetails::FExecutionDetails& InExecutionDetails =
 							FutureExecutionDetails::FExecutionDetails())
-			: State(MakeShared<TExpectedPromiseState<void>, ESPMode::ThreadSafe>(InExecutionDetails))
+			: State(new TExpectedPromiseState<void>(InExecutionDetails))
 		{
 		}
 
@@ -592,7 +1036,18 @@ namespace SD
 
 		TExpectedFuture<void> GetFuture()
 		{
-			return TExpectedFuture<void>(State);
+			checkf(!State.IsWriteOnly(), TEXT("Called GetFuture() on a write-only TExpectedPromise"));
+			return TExpectedFuture<void>(State.GetState());
+		}
+
+		/*
+		*	Gives up taking futures from this promise, and from copies made of it from now on. Until then the promise
+		*	could hand out a future that reads the value later, so continuations have to copy the value rather than
+		*	move it out of the state.
+		*/
+		void SetWriteOnly()
+		{
+			State.SetWriteOnly();
 		}
 
 		bool IsSet() const
@@ -602,7 +1057,7 @@ namespace SD
 
 		void SetValue(ExpectedResultType&& InResult)
 		{
-			State->SetValue(InResult);
+			State->SetValue(MoveTemp(InResult));
 		}
 
 		void SetValue()
@@ -617,42 +1072,42 @@ namespace SD
 
 		void Cancel()
 		{
-			SetValue(SD::MakeCancelledExpected());
+			State->Cancel();
+		}
+
+		//The shared state is the cancellable object, so this is what gets registered with an FCancellationHandle
+		CancellablePromiseRef GetCancellablePromise() const
+		{
+			return CancellablePromiseRef(State.GetState().GetReference());
 		}
 
 	private:
-		TSharedRef<TExpectedPromiseState<void>, ESPMode::ThreadSafe> State;
+		TExpectedPromiseStateRef<void> State;
 	};
 
+	//Ready futures are created with their value already set: one allocation and nothing to trigger.
 	template <class T>
-	TExpectedFuture<T> MakeReadyFuture(T&& InValue)
+	TExpectedFuture<T> MakeReadyFuture(TExpected<T>&& InExpected)
 	{
-		TExpectedPromise<T> ValuePromise = TExpectedPromise<T>();
-		ValuePromise.SetValue(SD::MakeReadyExpected<T>(Forward<T>(InValue)));
-		return ValuePromise.GetFuture();
+		return TExpectedFuture<T>(TRefCountPtr<TExpectedPromiseState<T>>(
+			new TExpectedPromiseState<T>(FutureExecutionDetails::FExecutionDetails(), MoveTemp(InExpected))));
 	}
 
 	template <class T>
-	TExpectedFuture<T> MakeReadyFuture(TExpected<T>&& InExpected)
+	TExpectedFuture<T> MakeReadyFuture(T&& InValue)
 	{
-		TExpectedPromise<T> ValuePromise = TExpectedPromise<T>();
-		ValuePromise.SetValue(Forward<TExpected<T>>(InExpected));
-		return ValuePromise.GetFuture();
+		return MakeReadyFuture<T>(SD::MakeReadyExpected<T>(Forward<T>(InValue)));
 	}
 
 	inline TExpectedFuture<void> MakeReadyFuture()
 	{
-		TExpectedPromise<void> ValuePromise = TExpectedPromise<void>();
-		ValuePromise.SetValue();
-		return ValuePromise.GetFuture();
+		return MakeReadyFuture<void>(SD::MakeReadyExpected());
 	}
 
 	template <typename T, typename R, typename TEnableIf<std::is_same_v<T, R>>::Type* = nullptr>
 	TExpectedFuture<T> MakeReadyFutureFromExpected(const TExpected<R>& InExpected)
 	{
-		TExpectedPromise<T> Promise = TExpectedPromise<T>();
-		Promise.SetValue(InExpected);
-		return Promise.GetFuture();
+		return MakeReadyFuture<T>(TExpected<T>(InExpected));
 	}
 
 	template <typename T, typename R, typename TEnableIf<!std::is_same_v<T, R>>::Type* = nullptr>
@@ -664,40 +1119,30 @@ namespace SD
 	template <typename T, typename R>
 	TExpectedFuture<T> MakeErrorFuture(const TExpected<R>& InExpected)
 	{
-		TExpectedPromise<T> ErrorPromise = TExpectedPromise<T>();
-		ErrorPromise.SetValue(ConvertIncomplete<T>(InExpected));
-		return ErrorPromise.GetFuture();
+		return MakeReadyFuture<T>(ConvertIncomplete<T>(InExpected));
 	}
 
 	template <typename T>
 	TExpectedFuture<T> MakeErrorFuture(const TExpected<T>& InExpected)
 	{
-		TExpectedPromise<T> ErrorPromise = TExpectedPromise<T>();
-		ErrorPromise.SetValue(InExpected);
-		return ErrorPromise.GetFuture();
+		return MakeReadyFuture<T>(TExpected<T>(InExpected));
 	}
 
 	template <typename T>
 	TExpectedFuture<T> MakeErrorFuture(TExpected<T>&& InExpected)
 	{
-		TExpectedPromise<T> ErrorPromise = TExpectedPromise<T>();
-		ErrorPromise.SetValue(Forward<TExpected<T>>(InExpected));
-		return ErrorPromise.GetFuture();
+		return MakeReadyFuture<T>(MoveTemp(InExpected));
 	}
 
 	template <typename T>
 	TExpectedFuture<T> MakeErrorFuture(const Error& InError)
 	{
-		TExpectedPromise<T> ErrorPromise = TExpectedPromise<T>();
-		ErrorPromise.SetValue(MakeErrorExpected<T>(InError));
-		return ErrorPromise.GetFuture();
+		return MakeReadyFuture<T>(MakeErrorExpected<T>(InError));
 	}
 
 	template <typename T>
 	TExpectedFuture<T> MakeErrorFuture(Error&& InError)
 	{
-		TExpectedPromise<T> ErrorPromise = TExpectedPromise<T>();
-		ErrorPromise.SetValue(MakeErrorExpected<T>(MoveTemp(InError)));
-		return ErrorPromise.GetFuture();
+		return MakeReadyFuture<T>(MakeErrorExpected<T>(MoveTemp(InError)));
 	}
 }
@@ -0,0 +1,358 @@
+// Copyright(c) Splash Damage. All rights reserved.
+#pragma once
+
+#include "ExpectedFuture.h"
+#include "Containers/Map.h"
+#include "HAL/CriticalSection.h"
+#include "HAL/PlatformTime.h"
+#include "Misc/ScopeLock.h"
+#include "Templates/Function.h"
+#include "Templates/UniquePtr.h"
+
+#include <type_traits>
+
+namespace SD
+{
+	struct FExpectedFutureCacheStats
+	{
+		//Fresh values, and requests that were already in flight
+		int64 NumHits = 0;
+
+		//Expired values returned while they are refreshed in the background
+		int64 NumStaleHits = 0;
+
+		int64 NumMisses = 0;
+
+		//Values dropped to stay within the entry or cost budget
+		int64 NumEvictions = 0;
+
+		//Including requests in flight
+		int32 NumEntries = 0;
+		int64 TotalCost = 0;
+	};
+
+	/*
+	*	Caches the results of asynchronous requests by key. Values expire after a time to live, and the least recently
+	*	used ones are evicted to stay within an entry and cost budget. Requests for a key that is already being loaded
+	*	share the future in flight rather than starting another one.
+	*
+	*	Errors are not cached, apart from those with one of the negative cache error codes, which are kept for a
+	*	shorter time so a missing resource is not requested again on every call. Cancellations are never cached.
+	*
+	*	With stale-while-revalidate, a hit on an expired value returns it straight away in a ready future and refreshes
+	*	it in the background, with at most one refresh in flight per key. A failed refresh keeps the stale value.
+	*
+	*	All of the bookkeeping happens under one lock, which is never held while calling a factory or setting a value.
+	*/
+	template<typename KeyType, typename T>
+	class TExpectedFutureCache
+	{
+		static_assert(!std::is_void<T>::value, "SD::TExpectedFutureCache - Must cache a value.");
+
+	public:
+		struct FSettings
+		{
+			//How long values stay fresh, unless a different time is passed to Get()
+			float TimeToLiveSeconds = 60.0f;
+
+			//Least recently used values are evicted to stay within both budgets. 0 means no limit.
+			int32 MaxEntries = 1024;
+			int64 MaxCost = 0;
+
+			//Cost of a value against MaxCost, such as its size in bytes. Every value costs 1 if unset.
+			TFunction<int64(const T&)> GetCost;
+
+			//Errors with these codes are cached for NegativeTimeToLiveSeconds, instead of being requested again
+			TArray<int32> NegativeCacheErrorCodes;
+			float NegativeTimeToLiveSeconds = 5.0f;
+
+			bool bStaleWhileRevalidate = false;
+		};
+
+		explicit TExpectedFutureCache(const FSettings& InSettings = FSettings())
+			: State(MakeShared<FState, ESPMode::ThreadSafe>(InSettings))
+		{}
+
+		TExpectedFutureCache(const TExpectedFutureCache&) = delete;
+		TExpectedFutureCache& operator=(const TExpectedFutureCache&) = delete;
+
+		/*
+		*	Returns the cached value for Key in a ready future, or calls Factory to load it. Factory is called as
+		*	SD::TExpectedFuture<T> Factory(), on the calling thread and outside of the lock.
+		*/
+		template<typename F>
+		TExpectedFuture<T> Get(const KeyType& Key, F&& Factory)
+		{
+			return Get(Key, Forward<F>(Factory), State->Settings.TimeToLiveSeconds);
+		}
+
+		template<typename F>
+		TExpectedFuture<T> Get(const KeyType& Key, F&& Factory, const float TimeToLiveSeconds)
+		{
+			using FutureType = std::decay_t<decltype(Factory())>;
+			static_assert(std::is_same<FutureType, TExpectedFuture<T>>::value, "SD::TExpectedFutureCache - Factory must return a TExpectedFuture<T>.");
+
+			TExpectedFuture<T> Result;
+			TExpectedPromise<T> LoadPromise;
+			uint64 EntryId = 0;
+			bool bLoad = false;
+			bool bRefresh = false;
+			{
+				FScopeLock Lock(&State->CriticalSection);
+				const double Now = FPlatformTime::Seconds();
+
+				if (TUniquePtr<FEntry>* Found = State->Entries.Find(Key))
+				{
+					FEntry& Entry = **Found;
+					if (!Entry.bHasValue)
+					{
+						++State->Stats.NumHits;
+						return Entry.Pending;
+					}
+
+					if (Now < Entry.ExpiryTime)
+					{
+						++State->Stats.NumHits;
+						State->Touch(Entry);
+						return MakeReadyFuture<T>(TExpected<T>(Entry.Value));
+					}
+
+					if (State->Settings.bStaleWhileRevalidate && Entry.Value.IsCompleted())
+					{
+						++State->Stats.NumStaleHits;
+						State->Touch(Entry);
+						Result = MakeReadyFuture<T>(TExpected<T>(Entry.Value));
+
+						bRefresh = !Entry.bRefreshing;
+						Entry.bRefreshing = true;
+						EntryId = Entry.Id;
+					}
+					else
+					{
+						State->Remove(Entry);
+					}
+				}
+
+				if (!bRefresh && !Result.IsValid())
+				{
+					++State->Stats.NumMisses;
+					FEntry& Entry = State->Add(Key);
+					Entry.Pending = LoadPromise.GetFuture();
+					Result = Entry.Pending;
+					EntryId = Entry.Id;
+					bLoad = true;
+				}
+			}
+
+			if (bLoad || bRefresh)
+			{
+				Factory().Then([State = State, Key, EntryId, TimeToLiveSeconds, bRefresh, LoadPromise](TExpected<T> Loaded) mutable
+				{
+					if (bRefresh)
+					{
+						State->OnRefreshed(Key, EntryId, TimeToLiveSeconds, Loaded);
+					}
+					else
+					{
+						State->OnLoaded(Key, EntryId, TimeToLiveSeconds, Loaded);
+						LoadPromise.SetValue(MoveTemp(Loaded));
+					}
+				}, FExpectedFutureOptions(EExpectedFutureExecutionPolicy::Inline));
+			}
+			return Result;
+		}
+
+		//Requests in flight for the key still complete, but their result is not cached
+		void Invalidate(const KeyType& Key)
+		{
+			FScopeLock Lock(&State->CriticalSection);
+			if (TUniquePtr<FEntry>* Found = State->Entries.Find(Key))
+			{
+				State->Remove(**Found);
+			}
+		}
+
+		void Clear()
+		{
+			FScopeLock Lock(&State->CriticalSection);
+			State->Clear();
+		}
+
+		FExpectedFutureCacheStats GetStats() const
+		{
+			FScopeLock Lock(&State->CriticalSection);
+			FExpectedFutureCacheStats Stats = State->Stats;
+			Stats.NumEntries = State->Entries.Num();
+			return Stats;
+		}
+
+	private:
+		struct FEntry
+		{
+			KeyType Key;
+
+			//Identifies this entry to the requests it starts, in case it is removed and the key added again
+			uint64 Id = 0;
+
+			//Shared by every caller until the first load completes
+			TExpectedFuture<T> Pending;
+
+			bool bHasValue = false;
+			bool bRefreshing = false;
+			TExpected<T> Value;
+			double ExpiryTime = 0.0;
+			int64 Cost = 0;
+
+			//Least recently used order, only for entries with a value
+			FEntry* Newer = nullptr;
+			FEntry* Older = nullptr;
+		};
+
+		//Shared with the requests in flight, so they can still complete if the cache is destroyed first
+		struct FState
+		{
+			explicit FState(const FSettings& InSettings)
+				: Settings(InSettings)
+			{}
+
+			FEntry& Add(const KeyType& Key)
+			{
+				TUniquePtr<FEntry>& Entry = Entries.Add(Key, MakeUnique<FEntry>());
+				Entry->Key = Key;
+				Entry->Id = ++LastEntryId;
+				return *Entry;
+			}
+
+			FEntry* Find(const KeyType& Key, const uint64 Id)
+			{
+				TUniquePtr<FEntry>* Found = Entries.Find(Key);
+				return Found && (*Found)->Id == Id ? Found->Get() : nullptr;
+			}
+
+			void Remove(FEntry& Entry)
+			{
+				if (Entry.bHasValue)
+				{
+					Unlink(Entry);
+					Stats.TotalCost -= Entry.Cost;
+				}
+				Entries.Remove(KeyType(Entry.Key));
+			}
+
+			void OnLoaded(const KeyType& Key, const uint64 Id, const float TimeToLiveSeconds, const TExpected<T>& Loaded)
+			{
+				FScopeLock Lock(&CriticalSection);
+				if (FEntry* Entry = Find(Key, Id))
+				{
+					//Later callers get the value from the entry, so the cache no longer needs to hold on to the future
+					Entry->Pending = TExpectedFuture<T>();
+
+					if (Loaded.IsCompleted())
+					{
+						SetValue(*Entry, Loaded, TimeToLiveSeconds);
+					}
+					else if (IsNegativeCached(Loaded))
+					{
+						SetValue(*Entry, Loaded, Settings.NegativeTimeToLiveSeconds);
+					}
+					else
+					{
+						Remove(*Entry);
+					}
+				}
+			}
+
+			void OnRefreshed(const KeyType& Key, const uint64 Id, const float TimeToLiveSeconds, const TExpected<T>& Loaded)
+			{
+				FScopeLock Lock(&CriticalSection);
+				if (FEntry* Entry = Find(Key, Id))
+				{
+					Entry->bRefreshing = false;
+					if (Loaded.IsCompleted())
+					{
+						SetValue(*Entry, Loaded, TimeToLiveSeconds);
+					}
+				}
+			}
+
+			void Clear()
+			{
+				Entries.Empty();
+				Newest = nullptr;
+				Oldest = nullptr;
+				NumLinked = 0;
+				Stats.TotalCost = 0;
+			}
+
+			void Touch(FEntry& Entry)
+			{
+				Unlink(Entry);
+				Link(Entry);
+			}
+
+			const FSettings Settings;
+
+			mutable FCriticalSection CriticalSection;
+			TMap<KeyType, TUniquePtr<FEntry>> Entries;
+			FExpectedFutureCacheStats Stats;
+
+		private:
+			void SetValue(FEntry& Entry, const TExpected<T>& Loaded, const float TimeToLiveSeconds)
+			{
+				if (Entry.bHasValue)
+				{
+					Unlink(Entry);
+					Stats.TotalCost -= Entry.Cost;
+				}
+
+				Entry.Value = Loaded;
+				Entry.bHasValue = true;
+				Entry.ExpiryTime = FPlatformTime::Seconds() + TimeToLiveSeconds;
+				Entry.Cost = !Loaded.IsCompleted() ? 0 : Settings.GetCost ? Settings.GetCost(*Loaded) : 1;
+
+				Stats.TotalCost += Entry.Cost;
+				Link(Entry);
+				EvictToBudget();
+			}
+
+			bool IsNegativeCached(const TExpected<T>& Loaded) const
+			{
+				return Loaded.IsError() && Settings.NegativeCacheErrorCodes.Contains(Loaded.GetError()->GetErrorCode());
+			}
+
+			void EvictToBudget()
+			{
+				while (Oldest && ((Settings.MaxEntries > 0 && NumLinked > Settings.MaxEntries) || (Settings.MaxCost > 0 && Stats.TotalCost > Settings.MaxCost)))
+				{
+					++Stats.NumEvictions;
+					Remove(*Oldest);
+				}
+			}
+
+			void Link(FEntry& Entry)
+			{
+				Entry.Older = Newest;
+				Entry.Newer = nullptr;
+				(Newest ? Newest->Newer : Oldest) = &Entry;
+				Newest = &Entry;
+				++NumLinked;
+			}
+
+			void Unlink(FEntry& Entry)
+			{
+				(Entry.Newer ? Entry.Newer->Older : Newest) = Entry.Older;
+				(Entry.Older ? Entry.Older->Newer : Oldest) = Entry.Newer;
+				Entry.Newer = nullptr;
+				Entry.Older = nullptr;
+				--NumLinked;
+			}
+
+			FEntry* Newest = nullptr;
+			FEntry* Oldest = nullptr;
+			int32 NumLinked = 0;
+			uint64 LastEntryId = 0;
+		};
+
+		TSharedRef<FState, ESPMode::ThreadSafe> State;
+	};
+}
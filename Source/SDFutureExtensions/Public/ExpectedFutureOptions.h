@@ -13,9 +13,10 @@ namespace SD
 		//thread it is being scheduled from using EAsyncExecution::TaskGraph
 		Current,
 
-		//Specifies that the function body associated with this future should be run on whatever
-		//thread the antecedent future was scheduled on. If there's no antecedent, defaults to
-		//Current.
+		//Specifies that the function body associated with this future should be run synchronously on
+		//whatever thread sets the antecedent future's value, or straight away on the calling thread if
+		//the antecedent is already set. Nothing is scheduled, so keep these continuations short and
+		//non-blocking. If there's no antecedent, defaults to Current.
 		Inline,
 
 		//Specifies that the function body associated with this future should be run on a specific
@@ -14,51 +14,13 @@ namespace SD
 		Error
 	};
 	
+	/*
+	*	State shared by every TExpected. Deliberately not polymorphic: TExpected is a tagged union of the value and the
+	*	error, so a completed result needs no allocation and an error costs a single one (shared between copies).
+	*/
 	class TExpectedBase
 	{
 	public:
-		
-		TExpectedBase()
-			: State(EExpectedResultState::Incomplete)
-		{}
-
-		virtual ~TExpectedBase()
-		{
-			InternalError.Reset();
-		}
-
-		TExpectedBase(const TExpectedBase& InValue) = default;
-		TExpectedBase(TExpectedBase&& InValue) = default;
-
-		TExpectedBase& operator=(const TExpectedBase& InExpected) = default;
-		TExpectedBase& operator=(TExpectedBase&& InValue) = default;
-
-		TExpectedBase(const Error& InError)
-			: State(EExpectedResultState::Error)
-			, InternalError(MakeShareable(new Error(InError)))
-		{}
-
-		TExpectedBase(Error&& InError)
-			: State(EExpectedResultState::Error)
-			, InternalError(MakeShareable(new Error(InError)))
-		{}
-
-		TExpectedBase& operator=(const Error& InError)
-		{
-			InternalError = MakeShareable(new Error(InError));
-			State = EExpectedResultState::Error;
-
-			return *this;
-		}
-
-		TExpectedBase& operator=(Error&& InError)
-		{
-			InternalError = MakeShareable(new Error(InError));
-			State = EExpectedResultState::Error;
-
-			return *this;
-		}
-
 		bool IsCompleted() const
 		{
 			return State == EExpectedResultState::Completed;
@@ -79,33 +41,39 @@ namespace SD
 			return State;
 		}
 
-		TSharedRef<Error, ESPMode::ThreadSafe> GetError() const
-		{
-			checkf(InternalError.IsValid() && IsError(), TEXT("Called GetError() on a non-error state TExpected"));
-			return InternalError.ToSharedRef();
-		}
-
 	protected:
+		using ErrorPtr = TSharedPtr<Error, ESPMode::ThreadSafe>;
 
 		struct FCancelledExpectedConstructorTag
 		{};
 
-		explicit TExpectedBase(FCancelledExpectedConstructorTag)
-			: State(EExpectedResultState::Cancelled)
+		explicit TExpectedBase(EExpectedResultState InState = EExpectedResultState::Incomplete)
+			: State(InState)
 		{}
 
-		void SetComplete()
+		//Never destroyed through a base pointer
+		~TExpectedBase() = default;
+
+		TExpectedBase(const TExpectedBase& InValue) = default;
+		TExpectedBase& operator=(const TExpectedBase& InValue) = default;
+
+		static ErrorPtr MakeErrorPtr(const Error& InError)
 		{
-			check(State == EExpectedResultState::Incomplete);
+			return MakeShared<Error, ESPMode::ThreadSafe>(InError);
+		}
 
-			InternalError.Reset();
-			State = EExpectedResultState::Completed;
+		static ErrorPtr MakeErrorPtr(Error&& InError)
+		{
+			return MakeShared<Error, ESPMode::ThreadSafe>(MoveTemp(InError));
 		}
 
-		EExpectedResultState State = EExpectedResultState::Incomplete;
-		TSharedPtr<Error, ESPMode::ThreadSafe> InternalError = nullptr;
+		EExpectedResultState State;
 	};
 
+	//Shares an existing error instead of copying it, so errors can be passed down a chain of different result types
+	struct FSharedErrorExpectedConstructorTag
+	{};
+
 	template <typename R>
 	class TExpected : public TExpectedBase
 	{
@@ -113,81 +81,149 @@ namespace SD
 		using ResultType = R;
 
 		TExpected(const ResultType& InValue)
-			: TExpectedBase()
-			, Value(InValue)
+			: TExpectedBase(EExpectedResultState::Completed)
 		{
-			SetComplete();
+			new (&Storage.Value) TOptional<ResultType>(InValue);
 		}
 
 		TExpected(ResultType&& InValue)
-			: TExpectedBase()
-			, Value(Forward<R>(InValue))
+			: TExpectedBase(EExpectedResultState::Completed)
+		{
+			new (&Storage.Value) TOptional<ResultType>(Forward<R>(InValue));
+		}
+
+		TExpected(const Error& InError)
+			: TExpectedBase(EExpectedResultState::Error)
+		{
+			new (&Storage.InternalError) ErrorPtr(MakeErrorPtr(InError));
+		}
+
+		TExpected(Error&& InError)
+			: TExpectedBase(EExpectedResultState::Error)
 		{
-			SetComplete();
+			new (&Storage.InternalError) ErrorPtr(MakeErrorPtr(MoveTemp(InError)));
+		}
+
+		TExpected(FSharedErrorExpectedConstructorTag, const TSharedRef<Error, ESPMode::ThreadSafe>& InError)
+			: TExpectedBase(EExpectedResultState::Error)
+		{
+			new (&Storage.InternalError) ErrorPtr(InError);
+		}
+
+		TExpected()
+			: TExpectedBase(EExpectedResultState::Incomplete)
+		{}
+
+		TExpected(const TExpected& InValue)
+			: TExpectedBase(InValue.State)
+		{
+			ConstructFrom(InValue);
+		}
+
+		TExpected(TExpected&& InValue)
+			: TExpectedBase(InValue.State)
+		{
+			ConstructFrom(MoveTemp(InValue));
 		}
 
 		~TExpected()
-		{	
-			Value.Reset();
+		{
+			Destroy();
 		}
 
-		TExpected() = default;
-		TExpected(const TExpected& InValue) = default;
-		TExpected(TExpected&& InValue) = default;
+		TExpected& operator=(const TExpected& InValue)
+		{
+			if (this != &InValue)
+			{
+				Destroy();
+				State = InValue.State;
+				ConstructFrom(InValue);
+			}
 
-		TExpected& operator=(const TExpected& InValue) = default;
-		TExpected& operator=(TExpected&& InValue) = default;
+			return *this;
+		}
 
-		TExpected& operator=(const ResultType& InValue)
+		TExpected& operator=(TExpected&& InValue)
 		{
-			Value = InValue;
-			SetComplete();
+			if (this != &InValue)
+			{
+				Destroy();
+				State = InValue.State;
+				ConstructFrom(MoveTemp(InValue));
+			}
 
 			return *this;
 		}
 
-		TExpected& operator=(ResultType&& InValue)
+		TExpected& operator=(const ResultType& InValue)
 		{
-			Value = MoveTempIfPossible(InValue);
-			SetComplete();
+			if (IsCompleted())
+			{
+				Storage.Value = InValue;
+			}
+			else
+			{
+				Destroy();
+				new (&Storage.Value) TOptional<ResultType>(InValue);
+				State = EExpectedResultState::Completed;
+			}
 
 			return *this;
 		}
 
-		TExpected(const Error& InError)
-			: TExpectedBase(InError)
-		{}
+		TExpected& operator=(ResultType&& InValue)
+		{
+			if (IsCompleted())
+			{
+				Storage.Value = MoveTempIfPossible(InValue);
+			}
+			else
+			{
+				Destroy();
+				new (&Storage.Value) TOptional<ResultType>(MoveTempIfPossible(InValue));
+				State = EExpectedResultState::Completed;
+			}
 
-		TExpected(Error&& InError)
-			: TExpectedBase(InError)
-		{}
+			return *this;
+		}
 
 		TExpected& operator=(const Error& InError)
 		{
-			TExpectedBase::operator=(InError);
-			Value.Reset();
-			
+			//Allocate first, InError may be owned by this
+			ErrorPtr NewError = MakeErrorPtr(InError);
+			Destroy();
+			new (&Storage.InternalError) ErrorPtr(MoveTemp(NewError));
+			State = EExpectedResultState::Error;
+
 			return *this;
 		}
 
 		TExpected& operator=(Error&& InError)
 		{
-			TExpectedBase::operator=(InError);
-			Value.Reset();
+			ErrorPtr NewError = MakeErrorPtr(MoveTemp(InError));
+			Destroy();
+			new (&Storage.InternalError) ErrorPtr(MoveTemp(NewError));
+			State = EExpectedResultState::Error;
 
 			return *this;
 		}
 
+		TSharedRef<Error, ESPMode::ThreadSafe> GetError() const
+		{
+			checkf(IsError() && Storage.InternalError.IsValid(), TEXT("Called GetError() on a non-error state TExpected"));
+			return Storage.InternalError.ToSharedRef();
+		}
+
 		TOptional<ResultType>& GetValue()
 		{
 			checkf(IsCompleted(), TEXT("Called GetValue() on a non-completed state TExpected"));
-			return Value;
+			return Storage.Value;
 		}
 
 		const TOptional<ResultType>& GetValue() const
 		{
 			checkf(IsCompleted(), TEXT("Called GetValue() on a non-completed state TExpected"));
-			return Value;
+			return Storage.Value;
 		}
 
 		ResultType& operator*()
@@ -208,10 +244,46 @@ namespace SD
 	private:
 
 		explicit TExpected(TExpectedBase::FCancelledExpectedConstructorTag Tag)
-			: TExpectedBase(Tag)
+			: TExpectedBase(EExpectedResultState::Cancelled)
 		{}
 
-		TOptional<ResultType> Value;
+		//Expects State to already match InValue
+		template<typename ExpectedType>
+		void ConstructFrom(ExpectedType&& InValue)
+		{
+			if (State == EExpectedResultState::Completed)
+			{
+				new (&Storage.Value) TOptional<ResultType>(Forward<ExpectedType>(InValue).Storage.Value);
+			}
+			else if (State == EExpectedResultState::Error)
+			{
+				new (&Storage.InternalError) ErrorPtr(Forward<ExpectedType>(InValue).Storage.InternalError);
+			}
+		}
+
+		void Destroy()
+		{
+			if (State == EExpectedResultState::Completed)
+			{
+				Storage.Value.~TOptional<ResultType>();
+			}
+			else if (State == EExpectedResultState::Error)
+			{
+				Storage.InternalError.~ErrorPtr();
+			}
+		}
+
+		//Only the member matching State is alive: Value when completed, InternalError on error, and neither otherwise
+		union FStorage
+		{
+			FStorage() {}
+			~FStorage() {}
+
+			TOptional<ResultType> Value;
+			ErrorPtr InternalError;
+		};
+
+		FStorage Storage;
 	};
 
 	struct FVoidExpectedConstructorTag
@@ -225,38 +297,63 @@ namespace SD
 
 		//Dummy value constructor overload to match TExpected<T> usage
 		explicit TExpected(FVoidExpectedConstructorTag)
-			: TExpectedBase()
+			: TExpectedBase(EExpectedResultState::Completed)
 		{
-			SetComplete();
 		}
 
 		TExpected() = default;
-		TExpected(const TExpected& InValue) = default;
-		TExpected(TExpected&& InValue) = default;
 
+		TExpected(const TExpected& InValue) = default;
 		TExpected& operator=(const TExpected& InValue) = default;
-		TExpected& operator=(TExpected&& InValue) = default;
+
+		TExpected(TExpected&& InValue)
+			: TExpectedBase(InValue.State)
+			, InternalError(MoveTemp(InValue.InternalError))
+		{
+		}
+
+		TExpected& operator=(TExpected&& InValue)
+		{
+			State = InValue.State;
+			InternalError = MoveTemp(InValue.InternalError);
+			return *this;
+		}
 
 		TExpected(const Error& InError)
-			: TExpectedBase(InError)
+			: TExpectedBase(EExpectedResultState::Error)
+			, InternalError(MakeErrorPtr(InError))
 		{}
 
 		TExpected(Error&& InError)
-			: TExpectedBase(InError)
+			: TExpectedBase(EExpectedResultState::Error)
+			, InternalError(MakeErrorPtr(MoveTemp(InError)))
+		{}
+
+		TExpected(FSharedErrorExpectedConstructorTag, const TSharedRef<Error, ESPMode::ThreadSafe>& InError)
+			: TExpectedBase(EExpectedResultState::Error)
+			, InternalError(InError)
 		{}
 
 		TExpected& operator=(const Error& InError)
 		{
-			TExpectedBase::operator=(InError);
+			InternalError = MakeErrorPtr(InError);
+			State = EExpectedResultState::Error;
 			return *this;
 		}
 
 		TExpected& operator=(Error&& InError)
 		{
-			TExpectedBase::operator=(InError);
+			InternalError = MakeErrorPtr(MoveTemp(InError));
+			State = EExpectedResultState::Error;
 			return *this;
 		}
 
+		TSharedRef<Error, ESPMode::ThreadSafe> GetError() const
+		{
+			checkf(IsError() && InternalError.IsValid(), TEXT("Called GetError() on a non-error state TExpected"));
+			return InternalError.ToSharedRef();
+		}
+
 		static TExpected<void> MakeCancelled()
 		{
 			return TExpected<void>(TExpectedBase::FCancelledExpectedConstructorTag());
@@ -265,8 +362,11 @@ namespace SD
 	private:
 
 		explicit TExpected(TExpectedBase::FCancelledExpectedConstructorTag Tag)
-			: TExpectedBase(Tag)
+			: TExpectedBase(EExpectedResultState::Cancelled)
 		{}
+
+		//Only set in the Error state
+		ErrorPtr InternalError;
 	};
 
 	template <typename R>
@@ -290,7 +390,13 @@ namespace SD
 	template <typename R>
 	TExpected<R> MakeErrorExpected(Error&& InError)
 	{
-		return TExpected<R>(Forward<Error>(InError));
+		return TExpected<R>(MoveTemp(InError));
+	}
+
+	template <typename R>
+	TExpected<R> MakeErrorExpected(const TSharedRef<Error, ESPMode::ThreadSafe>& InError)
+	{
+		return TExpected<R>(FSharedErrorExpectedConstructorTag(), InError);
 	}
 
 	template <typename R>
@@ -314,6 +420,11 @@ namespace SD
 		return TExpected<void>(Forward<Error>(InError));
 	}
 
+	inline TExpected<void> MakeErrorExpected(const TSharedRef<Error, ESPMode::ThreadSafe>& InError)
+	{
+		return TExpected<void>(FSharedErrorExpectedConstructorTag(), InError);
+	}
+
 	inline TExpected<void> MakeCancelledExpected()
 	{
 		return TExpected<void>::MakeCancelled();
@@ -329,7 +440,7 @@ namespace SD
 		case EExpectedResultState::Cancelled:
 			return MakeCancelledExpected<R>();
 		case EExpectedResultState::Error:
-			return MakeErrorExpected<R>(*Other.GetError());
+			return MakeErrorExpected<R>(Other.GetError());
 		case EExpectedResultState::Incomplete:
 		default:
 			return TExpected<R>();
@@ -346,7 +457,7 @@ namespace SD
 		case EExpectedResultState::Cancelled:
 			return MakeCancelledExpected();
 		case EExpectedResultState::Error:
-			return MakeErrorExpected(*Other.GetError());
+			return MakeErrorExpected(Other.GetError());
 		case EExpectedResultState::Incomplete:
 		default:
 			return TExpected<void>();
@@ -361,7 +472,7 @@ namespace SD
 		case EExpectedResultState::Cancelled:
 			return MakeCancelledExpected<R>();
 		case EExpectedResultState::Error:
-			return MakeErrorExpected<R>(*Other.GetError());
+			return MakeErrorExpected<R>(Other.GetError());
 		case EExpectedResultState::Completed:
 			checkf(false, TEXT("This should only be called from incomplete TExpected"));
 		case EExpectedResultState::Incomplete:
@@ -378,7 +489,7 @@ namespace SD
 		case EExpectedResultState::Cancelled:
 			return MakeCancelledExpected<void>();
 		case EExpectedResultState::Error:
-			return MakeErrorExpected<void>(*Other.GetError());
+			return MakeErrorExpected<void>(Other.GetError());
 		case EExpectedResultState::Completed:
 			checkf(false, TEXT("This should only be called from incomplete TExpected"));
 		case EExpectedResultState::Incomplete:
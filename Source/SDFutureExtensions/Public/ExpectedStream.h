@@ -0,0 +1,595 @@
+// Copyright(c) Splash Damage. All rights reserved.
+#pragma once
+
+#include "ExpectedFuture.h"
+#include "FutureExtensionTaskGraph.h"
+#include "FutureExtensionsTypeTraits.h"
+#include "HAL/CriticalSection.h"
+#include "Misc/Optional.h"
+#include "Misc/ScopeLock.h"
+#include "Templates/Function.h"
+#include "WaiterQueue.h"
+
+#include <atomic>
+#include <type_traits>
+
+namespace SD
+{
+	template<typename T>
+	class TExpectedStream;
+
+	namespace Details
+	{
+		/*
+		*	Read side of a stream, one per operator. Only the buffer at the start of the chain ever has to wait, so
+		*	operators are applied as part of the consumer's call to TryRead() rather than through a future per element.
+		*/
+		template<typename T>
+		class TStreamReader
+		{
+		public:
+			using ResultType = TExpected<TOptional<T>>;
+
+			virtual ~TStreamReader() = default;
+
+			//The next element, an unset optional once the stream has ended, or why it failed. Unset if it has to wait.
+			virtual TOptional<ResultType> TryRead() = 0;
+
+			//Calls OnReadable once TryRead() may have something new, or returns false if it already may
+			virtual bool WaitUntilReadable(TFunction<void()>&& OnReadable) = 0;
+		};
+
+		/*
+		*	Bounded buffer between the producer and the first reader. Writes beyond the capacity are held back, along
+		*	with the producer's future, until the consumer makes room for them.
+		*
+		*	Registered with the stream's FCancellationHandle like a promise, so cancelling the handle reaches both ends.
+		*/
+		template<typename T>
+		class TStreamBuffer final : public FCancellablePromise
+		{
+		public:
+			explicit TStreamBuffer(const int32 Capacity)
+			{
+				Slots.SetNum(Capacity);
+			}
+
+			TExpectedFuture<void> Write(T&& Value)
+			{
+				TFunction<void()> OnReadable;
+				{
+					FScopeLock Lock(&CriticalSection);
+					if (bCancelled)
+					{
+						return MakeReadyFuture<void>(MakeCancelledExpected());
+					}
+					if (bClosed)
+					{
+						return MakeErrorFuture<void>(Error::Static(Errors::ERROR_INVALID_ARGUMENT, TEXT("SD::TExpectedStreamWriter - Written to after being closed")));
+					}
+					if (NumValues == Slots.Num())
+					{
+						FBlockedWrite* Blocked = new FBlockedWrite(MoveTemp(Value));
+						BlockedWrites.PushBack(*Blocked);
+						return Blocked->Promise.GetFuture();
+					}
+
+					Push(MoveTemp(Value));
+					OnReadable = MoveTemp(ConsumerWaiter);
+				}
+
+				if (OnReadable)
+				{
+					OnReadable();
+				}
+				return MakeReadyFuture();
+			}
+
+			void Close(TOptional<Error>&& InError)
+			{
+				TFunction<void()> OnReadable;
+				{
+					FScopeLock Lock(&CriticalSection);
+					if (bClosed || bCancelled)
+					{
+						return;
+					}
+
+					bClosed = true;
+					CloseError = MoveTemp(InError);
+					OnReadable = MoveTemp(ConsumerWaiter);
+				}
+
+				if (OnReadable)
+				{
+					OnReadable();
+				}
+			}
+
+			void CancelStream()
+			{
+				TFunction<void()> OnReadable;
+				TArray<TRefCountPtr<FBlockedWrite>> Unblocked;
+				{
+					FScopeLock Lock(&CriticalSection);
+					if (bCancelled)
+					{
+						return;
+					}
+
+					bCancelled = true;
+					OnReadable = MoveTemp(ConsumerWaiter);
+					while (!BlockedWrites.IsEmpty())
+					{
+						Unblocked.Add(BlockedWrites.PopFront());
+					}
+					for (TOptional<T>& Slot : Slots)
+					{
+						Slot.Reset();
+					}
+					NumValues = 0;
+				}
+
+				for (const TRefCountPtr<FBlockedWrite>& Blocked : Unblocked)
+				{
+					Blocked->Promise.Cancel();
+				}
+				if (OnReadable)
+				{
+					OnReadable();
+				}
+			}
+
+			bool IsCancelled() const
+			{
+				FScopeLock Lock(&CriticalSection);
+				return bCancelled;
+			}
+
+			TOptional<TExpected<TOptional<T>>> TryRead()
+			{
+				TOptional<TExpected<TOptional<T>>> Result;
+				TRefCountPtr<FBlockedWrite> Unblocked;
+				{
+					FScopeLock Lock(&CriticalSection);
+					if (bCancelled)
+					{
+						Result.Emplace(MakeCancelledExpected<TOptional<T>>());
+					}
+					else if (NumValues > 0)
+					{
+						Result.Emplace(MakeReadyExpected<TOptional<T>>(TOptional<T>(Pop())));
+
+						//Oldest held back write takes the slot that was just freed
+						if (!BlockedWrites.IsEmpty())
+						{
+							Unblocked = BlockedWrites.PopFront();
+							Push(MoveTemp(Unblocked->Value));
+						}
+					}
+					else if (bClosed)
+					{
+						Result.Emplace(CloseError.IsSet()
+							? MakeErrorExpected<TOptional<T>>(CloseError.GetValue())
+							: MakeReadyExpected<TOptional<T>>(TOptional<T>()));
+					}
+				}
+
+				if (Unblocked.IsValid())
+				{
+					Unblocked->Promise.SetValue();
+				}
+				return Result;
+			}
+
+			bool WaitUntilReadable(TFunction<void()>&& OnReadable)
+			{
+				FScopeLock Lock(&CriticalSection);
+				if (bCancelled || bClosed || NumValues > 0)
+				{
+					return false;
+				}
+
+				ConsumerWaiter = MoveTemp(OnReadable);
+				return true;
+			}
+
+		protected:
+			virtual void Cancel() override
+			{
+				CancelStream();
+			}
+
+			virtual bool IsSet() const override
+			{
+				FScopeLock Lock(&CriticalSection);
+				return bCancelled || (bClosed && NumValues == 0);
+			}
+
+		private:
+			class FBlockedWrite final : public FFutureAllocated, public TWaiterQueueLink<FBlockedWrite>
+			{
+			public:
+				explicit FBlockedWrite(T&& InValue)
+					: Value(MoveTemp(InValue))
+					, RefCount(0)
+				{}
+
+				FBlockedWrite(const FBlockedWrite&) = delete;
+				FBlockedWrite& operator=(const FBlockedWrite&) = delete;
+
+				uint32 AddRef() const
+				{
+					return uint32(RefCount.fetch_add(1, std::memory_order_relaxed) + 1);
+				}
+
+				uint32 Release() const
+				{
+					const int32 NewRefCount = RefCount.fetch_sub(1, std::memory_order_acq_rel) - 1;
+					if (NewRefCount == 0)
+					{
+						delete this;
+					}
+					return uint32(NewRefCount);
+				}
+
+				T Value;
+				TExpectedPromise<void> Promise;
+
+			private:
+				mutable std::atomic<int32> RefCount;
+			};
+
+			void Push(T&& Value)
+			{
+				Slots[(Head + NumValues) % Slots.Num()].Emplace(MoveTemp(Value));
+				++NumValues;
+			}
+
+			T Pop()
+			{
+				TOptional<T>& Slot = Slots[Head];
+				T Value = MoveTemp(Slot.GetValue());
+				Slot.Reset();
+				Head = (Head + 1) % Slots.Num();
+				--NumValues;
+				return Value;
+			}
+
+			mutable FCriticalSection CriticalSection;
+
+			//Ring buffer of NumValues elements, starting at Head
+			TArray<TOptional<T>> Slots;
+			int32 Head = 0;
+			int32 NumValues = 0;
+
+			TWaiterQueue<FBlockedWrite> BlockedWrites;
+			TFunction<void()> ConsumerWaiter;
+
+			bool bClosed = false;
+			bool bCancelled = false;
+			TOptional<Error> CloseError;
+		};
+
+		template<typename T>
+		class TStreamBufferReader final : public TStreamReader<T>
+		{
+		public:
+			explicit TStreamBufferReader(const TRefCountPtr<TStreamBuffer<T>>& InBuffer)
+				: Buffer(InBuffer)
+			{}
+
+			//Nothing can read the stream any more, so there is no point in the producer carrying on
+			virtual ~TStreamBufferReader() override
+			{
+				Buffer->CancelStream();
+			}
+
+			virtual TOptional<typename TStreamReader<T>::ResultType> TryRead() override
+			{
+				return Buffer->TryRead();
+			}
+
+			virtual bool WaitUntilReadable(TFunction<void()>&& OnReadable) override
+			{
+				return Buffer->WaitUntilReadable(MoveTemp(OnReadable));
+			}
+
+		private:
+			TRefCountPtr<TStreamBuffer<T>> Buffer;
+		};
+
+		//For operators to pass on the end of the stream, errors and cancellation
+		template<typename R, typename T>
+		TExpected<TOptional<R>> ConvertStreamEnd(const TExpected<TOptional<T>>& Result)
+		{
+			return Result.IsCompleted() ? MakeReadyExpected<TOptional<R>>(TOptional<R>()) : ConvertIncomplete<TOptional<R>, TOptional<T>>(Result);
+		}
+
+		template<typename T, typename R, typename F>
+		class TStreamMapReader final : public TStreamReader<R>
+		{
+		public:
+			TStreamMapReader(const TSharedRef<TStreamReader<T>, ESPMode::ThreadSafe>& InInner, F&& InFunc)
+				: Inner(InInner)
+				, Func(MoveTemp(InFunc))
+			{}
+
+			virtual TOptional<TExpected<TOptional<R>>> TryRead() override
+			{
+				TOptional<TExpected<TOptional<T>>> Result = Inner->TryRead();
+				if (!Result.IsSet())
+				{
+					return {};
+				}
+
+				TExpected<TOptional<T>>& Expected = Result.GetValue();
+				if (Expected.IsCompleted() && (*Expected).IsSet())
+				{
+					return MakeReadyExpected<TOptional<R>>(TOptional<R>(Func(MoveTemp((*Expected).GetValue()))));
+				}
+				return ConvertStreamEnd<R>(Expected);
+			}
+
+			virtual bool WaitUntilReadable(TFunction<void()>&& OnReadable) override
+			{
+				return Inner->WaitUntilReadable(MoveTemp(OnReadable));
+			}
+
+		private:
+			TSharedRef<TStreamReader<T>, ESPMode::ThreadSafe> Inner;
+			F Func;
+		};
+
+		template<typename T, typename F>
+		class TStreamFilterReader final : public TStreamReader<T>
+		{
+		public:
+			TStreamFilterReader(const TSharedRef<TStreamReader<T>, ESPMode::ThreadSafe>& InInner, F&& InPredicate)
+				: Inner(InInner)
+				, Predicate(MoveTemp(InPredicate))
+			{}
+
+			virtual TOptional<TExpected<TOptional<T>>> TryRead() override
+			{
+				//Skips as many elements as are available, rather than waiting for each one
+				while (true)
+				{
+					TOptional<TExpected<TOptional<T>>> Result = Inner->TryRead();
+					if (!Result.IsSet())
+					{
+						return Result;
+					}
+
+					const TExpected<TOptional<T>>& Expected = Result.GetValue();
+					if (!Expected.IsCompleted() || !(*Expected).IsSet() || Predicate((*Expected).GetValue()))
+					{
+						return Result;
+					}
+				}
+			}
+
+			virtual bool WaitUntilReadable(TFunction<void()>&& OnReadable) override
+			{
+				return Inner->WaitUntilReadable(MoveTemp(OnReadable));
+			}
+
+		private:
+			TSharedRef<TStreamReader<T>, ESPMode::ThreadSafe> Inner;
+			F Predicate;
+		};
+
+		template<typename T>
+		class TStreamBatchReader final : public TStreamReader<TArray<T>>
+		{
+		public:
+			TStreamBatchReader(const TSharedRef<TStreamReader<T>, ESPMode::ThreadSafe>& InInner, const int32 InBatchSize)
+				: Inner(InInner)
+				, BatchSize(InBatchSize)
+			{
+				Batch.Reserve(BatchSize);
+			}
+
+			virtual TOptional<TExpected<TOptional<TArray<T>>>> TryRead() override
+			{
+				if (Ended.IsSet())
+				{
+					return ConvertStreamEnd<TArray<T>>(Ended.GetValue());
+				}
+
+				while (Batch.Num() < BatchSize)
+				{
+					TOptional<TExpected<TOptional<T>>> Result = Inner->TryRead();
+					if (!Result.IsSet())
+					{
+						return {};
+					}
+
+					TExpected<TOptional<T>>& Expected = Result.GetValue();
+					if (!Expected.IsCompleted() || !(*Expected).IsSet())
+					{
+						//A partial batch is still passed on before the end of the stream, but not before an error
+						if (Expected.IsCompleted() && Batch.Num() > 0)
+						{
+							Ended.Emplace(MoveTemp(Expected));
+							break;
+						}
+						return ConvertStreamEnd<TArray<T>>(Expected);
+					}
+					Batch.Add(MoveTemp((*Expected).GetValue()));
+				}
+
+				TArray<T> Full = MoveTemp(Batch);
+				Batch.Reset(BatchSize);
+				return MakeReadyExpected<TOptional<TArray<T>>>(TOptional<TArray<T>>(MoveTemp(Full)));
+			}
+
+			virtual bool WaitUntilReadable(TFunction<void()>&& OnReadable) override
+			{
+				return Ended.IsSet() ? false : Inner->WaitUntilReadable(MoveTemp(OnReadable));
+			}
+
+		private:
+			TSharedRef<TStreamReader<T>, ESPMode::ThreadSafe> Inner;
+			const int32 BatchSize;
+
+			//Only touched by the consumer
+			TArray<T> Batch;
+			TOptional<TExpected<TOptional<T>>> Ended;
+		};
+	}
+
+	//Write side of a TExpectedStream, see MakeStream
+	template<typename T>
+	class TExpectedStreamWriter
+	{
+	public:
+		//Completes once the value is in the buffer, straight away unless it is full. Wait for it before writing more.
+		TExpectedFuture<void> Write(T Value) const
+		{
+			return Buffer->Write(MoveTemp(Value));
+		}
+
+		//Ends the stream once the consumer has read everything before it
+		void Close() const
+		{
+			Buffer->Close(TOptional<Error>());
+		}
+
+		//Fails the stream once the consumer has read everything before it
+		void Fail(Error InError) const
+		{
+			Buffer->Close(TOptional<Error>(MoveTemp(InError)));
+		}
+
+		//Set once the consumer has cancelled the stream, or stopped reading it altogether
+		bool IsCancelled() const
+		{
+			return Buffer->IsCancelled();
+		}
+
+	private:
+		template<typename U, typename F>
+		friend TExpectedStream<U> MakeStream(const int32 Capacity, F&& Producer, const FExpectedFutureOptions& Options);
+
+		explicit TExpectedStreamWriter(const TRefCountPtr<Details::TStreamBuffer<T>>& InBuffer)
+			: Buffer(InBuffer)
+		{}
+
+		TRefCountPtr<Details::TStreamBuffer<T>> Buffer;
+	};
+
+	/*
+	*	A sequence of values that arrive over time, read one at a time with Next(). Created with MakeStream, and only
+	*	meant to be read by one consumer, which should wait for each Next() before calling it again.
+	*
+	*	Map, Filter and Batch return a stream that applies the operator to this one as it is read, so they add no
+	*	buffering or futures of their own. The stream they are called on should no longer be read directly.
+	*	Once every copy of a stream (and of the streams made from it) is gone, the stream is cancelled.
+	*/
+	template<typename T>
+	class TExpectedStream
+	{
+		using ReaderRef = TSharedRef<Details::TStreamReader<T>, ESPMode::ThreadSafe>;
+		using ReaderWeakPtr = TWeakPtr<Details::TStreamReader<T>, ESPMode::ThreadSafe>;
+
+	public:
+		//Completes with the next value, an unset optional once the stream has ended, or the error it failed with
+		TExpectedFuture<TOptional<T>> Next() const
+		{
+			if (TOptional<TExpected<TOptional<T>>> Result = Reader->TryRead())
+			{
+				return MakeReadyFuture<TOptional<T>>(MoveTemp(Result.GetValue()));
+			}
+
+			TExpectedPromise<TOptional<T>> Promise;
+			WaitForNext(Reader, Promise);
+			return Promise.GetFuture();
+		}
+
+		template<typename F>
+		auto Map(F&& Func) const
+		{
+			using R = std::decay_t<decltype(Func(std::declval<T&&>()))>;
+			using FReader = Details::TStreamMapReader<T, R, std::decay_t<F>>;
+			return TExpectedStream<R>(MakeShared<FReader, ESPMode::ThreadSafe>(Reader, std::decay_t<F>(Forward<F>(Func))));
+		}
+
+		template<typename F>
+		TExpectedStream<T> Filter(F&& Predicate) const
+		{
+			using FReader = Details::TStreamFilterReader<T, std::decay_t<F>>;
+			return TExpectedStream<T>(MakeShared<FReader, ESPMode::ThreadSafe>(Reader, std::decay_t<F>(Forward<F>(Predicate))));
+		}
+
+		//Groups values into arrays of BatchSize, apart from the last one which may be smaller
+		TExpectedStream<TArray<T>> Batch(const int32 BatchSize) const
+		{
+			check(BatchSize > 0);
+			return TExpectedStream<TArray<T>>(MakeShared<Details::TStreamBatchReader<T>, ESPMode::ThreadSafe>(Reader, BatchSize));
+		}
+
+	private:
+		template<typename U>
+		friend class TExpectedStream;
+
+		template<typename U, typename F>
+		friend TExpectedStream<U> MakeStream(const int32 Capacity, F&& Producer, const FExpectedFutureOptions& Options);
+
+		explicit TExpectedStream(const ReaderRef& InReader)
+			: Reader(InReader)
+		{}
+
+		//Only holds on to the reader weakly while waiting, so dropping the stream still cancels it
+		static void WaitForNext(const ReaderRef& InReader, TExpectedPromise<TOptional<T>> Promise)
+		{
+			const ReaderWeakPtr WeakReader = InReader;
+			while (!InReader->WaitUntilReadable([WeakReader, Promise]() mutable
+			{
+				const TSharedPtr<Details::TStreamReader<T>, ESPMode::ThreadSafe> PinnedReader = WeakReader.Pin();
+				if (!PinnedReader.IsValid())
+				{
+					Promise.SetValue(MakeCancelledExpected<TOptional<T>>());
+				}
+				else if (TOptional<TExpected<TOptional<T>>> Result = PinnedReader->TryRead())
+				{
+					Promise.SetValue(MoveTemp(Result.GetValue()));
+				}
+				else
+				{
+					WaitForNext(PinnedReader.ToSharedRef(), Promise);
+				}
+			}))
+			{
+				//Became readable before the callback could be registered
+				if (TOptional<TExpected<TOptional<T>>> Result = InReader->TryRead())
+				{
+					Promise.SetValue(MoveTemp(Result.GetValue()));
+					return;
+				}
+			}
+		}
+
+		ReaderRef Reader;
+	};
+
+	/*
+	*	Creates a stream that buffers up to Capacity values, and calls Producer with the writer for it:
+	*	void Producer(const SD::TExpectedStreamWriter<T>& Writer)
+	*	The producer should wait for each Write() to complete before writing more, which holds it back while the
+	*	consumer is behind. Cancelling the handle in Options cancels the stream, as does the consumer dropping it;
+	*	either way any pending writes are cancelled and the writer reports IsCancelled().
+	*/
+	template<typename T, typename F>
+	TExpectedStream<T> MakeStream(const int32 Capacity, F&& Producer, const FExpectedFutureOptions& Options = FExpectedFutureOptions())
+	{
+		check(Capacity > 0);
+
+		const TRefCountPtr<Details::TStreamBuffer<T>> Buffer(new Details::TStreamBuffer<T>(Capacity));
+		FutureExtensionTaskGraph::TryAddPromiseToCancellationHandle(Options.GetCancellationTokenHandle(), CancellablePromiseRef(Buffer.GetReference()));
+
+		TExpectedStream<T> Stream(MakeShared<Details::TStreamBufferReader<T>, ESPMode::ThreadSafe>(Buffer));
+		Producer(TExpectedStreamWriter<T>(Buffer));
+		return Stream;
+	}
+}
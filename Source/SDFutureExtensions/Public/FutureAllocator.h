@@ -0,0 +1,79 @@
+// Copyright(c) Splash Damage. All rights reserved.
+#pragma once
+
+#include "CoreMinimal.h"
+
+#include <new>
+
+//Allocate promise states, continuations and queued work from size-class slabs with thread-local caches.
+//Set to 0 to route them straight to the global allocator instead.
+#ifndef SDFUTUREEXTENSIONS_POOLED_ALLOCATOR
+	#define SDFUTUREEXTENSIONS_POOLED_ALLOCATOR 1
+#endif
+
+//Keep track of blocks and bytes in use by the future allocator. This costs a couple of shared atomics per allocation.
+#ifndef SDFUTUREEXTENSIONS_ALLOCATOR_STATS
+	#define SDFUTUREEXTENSIONS_ALLOCATOR_STATS !UE_BUILD_SHIPPING
+#endif
+
+namespace SD
+{
+	namespace FutureAllocator
+	{
+		struct FPoolStats
+		{
+			int32 BlockSize = 0;
+			int32 NumBlocksInUse = 0;
+			int32 HighWaterMark = 0;
+		};
+
+		struct FStats
+		{
+			//One entry per size class. Empty if the pooled allocator is disabled.
+			TArray<FPoolStats> Pools;
+
+			//Allocations that are too large for any size class (or all of them if pooling is disabled)
+			int64 UnpooledBytesInUse = 0;
+			int64 UnpooledBytesHighWaterMark = 0;
+
+			//Pooled blocks in use (counting their full block size) plus unpooled allocations
+			int64 BytesInUse = 0;
+		};
+
+		SDFUTUREEXTENSIONS_API void* Malloc(SIZE_T Size);
+		SDFUTUREEXTENSIONS_API void Free(void* Ptr, SIZE_T Size);
+
+		//Number of allocations made through Malloc() on the calling thread. Used to keep track of what each link in a
+		//chain costs; being per-thread keeps it both cheap and unaffected by futures completing elsewhere.
+		SDFUTUREEXTENSIONS_API uint64 GetNumAllocationsOnCurrentThread();
+
+		//Always empty unless SDFUTUREEXTENSIONS_ALLOCATOR_STATS is enabled.
+		SDFUTUREEXTENSIONS_API FStats GetStats();
+	}
+
+	//Routes heap allocations of the deriving class through FutureAllocator.
+	class FFutureAllocated
+	{
+	public:
+		static void* operator new(size_t Size)
+		{
+			return FutureAllocator::Malloc(Size);
+		}
+
+		static void operator delete(void* Ptr, size_t Size)
+		{
+			FutureAllocator::Free(Ptr, Size);
+		}
+
+		//Size classes only guarantee the default alignment, so over-aligned types bypass them.
+		static void* operator new(size_t Size, std::align_val_t Alignment)
+		{
+			return FMemory::Malloc(Size, static_cast<uint32>(Alignment));
+		}
+
+		static void operator delete(void* Ptr, size_t Size, std::align_val_t Alignment)
+		{
+			FMemory::Free(Ptr);
+		}
+	};
+}
@@ -31,6 +31,38 @@ namespace SD
 				ToSet.SetValue(MoveTemp(ConvertedExpected));
 			}
 
+			/*
+			*	Calls a continuation with a value owned by its antecedent. The value is moved in if no other future can
+			*	read it, and passed by const reference otherwise (or as a copy, if the continuation takes a non-const one).
+			*/
+			template<typename Function, typename ValueType>
+			decltype(auto) InvokeWithPreviousValue(Function& ContinuationFunction, ValueType& Value, const bool bCanMove)
+			{
+				constexpr bool bTakesRValue = std::is_invocable_v<Function&, ValueType&&>;
+				constexpr bool bTakesConstRef = std::is_invocable_v<Function&, const ValueType&>;
+
+				if (bCanMove)
+				{
+					if constexpr (bTakesRValue)
+					{
+						return ContinuationFunction(MoveTemp(Value));
+					}
+					else
+					{
+						return ContinuationFunction(Value);
+					}
+				}
+				else if constexpr (bTakesConstRef)
+				{
+					return ContinuationFunction(static_cast<const ValueType&>(Value));
+				}
+				else
+				{
+					ValueType Copy(Value);
+					return ContinuationFunction(Copy);
+				}
+			}
+
 			/*
 			*	Executes an initial function that:
 			*		- Takes no parameters
@@ -94,9 +126,10 @@ namespace SD
 					TExpectedFuture<FutureType>& PreviousFuture,
 					TExpectedPromise<PromiseType>& ContinuationPromise)
 			{
-				check(PreviousFuture.IsReady());
+				bool bCanMove = false;
+				auto& PrevExpected = PreviousFuture.GetValueForContinuation(bCanMove);
 
-				ContinuationFunction(PreviousFuture.Get())
+				InvokeWithPreviousValue(ContinuationFunction, PrevExpected, bCanMove)
 					.Then([p = MoveTemp(ContinuationPromise)](TExpected<PromiseType> Expected) mutable {
 					p.SetValue(MoveTemp(Expected));
 				});
@@ -116,11 +149,11 @@ namespace SD
 					TExpectedFuture<FutureType>& PreviousFuture,
 					TExpectedPromise<PromiseType>& ContinuationPromise)
 			{
-				check(PreviousFuture.IsReady());
-				auto PrevExpected = PreviousFuture.Get();
+				bool bCanMove = false;
+				auto& PrevExpected = PreviousFuture.GetValueForContinuation(bCanMove);
 				if (PrevExpected.IsCompleted())
 				{
-					ContinuationFunction(*PrevExpected)
+					InvokeWithPreviousValue(ContinuationFunction, *PrevExpected, bCanMove)
 						.Then([p = MoveTemp(ContinuationPromise)](TExpected<PromiseType> Expected) mutable {
 						p.SetValue(MoveTemp(Expected));
 					});
@@ -145,8 +178,8 @@ namespace SD
 					TExpectedFuture<FutureType>& PreviousFuture,
 					TExpectedPromise<PromiseType>& ContinuationPromise)
 			{
-				check(PreviousFuture.IsReady());
-				auto PrevExpected = PreviousFuture.Get();
+				bool bCanMove = false;
+				const auto& PrevExpected = PreviousFuture.GetValueForContinuation(bCanMove);
 				if (PrevExpected.IsCompleted())
 				{
 					ContinuationFunction()
@@ -174,8 +207,9 @@ namespace SD
 					TExpectedFuture<FutureType>& PreviousFuture,
 					TExpectedPromise<PromiseType>& ContinuationPromise)
 			{
-				check(PreviousFuture.IsReady());
-				ContinuationPromise.SetValue(ContinuationFunction(PreviousFuture.Get()));
+				bool bCanMove = false;
+				auto& PrevExpected = PreviousFuture.GetValueForContinuation(bCanMove);
+				ContinuationPromise.SetValue(InvokeWithPreviousValue(ContinuationFunction, PrevExpected, bCanMove));
 			}
 
 			/*
@@ -192,11 +226,11 @@ namespace SD
 					TExpectedFuture<FutureType>& PreviousFuture,
 					TExpectedPromise<PromiseType>& ContinuationPromise)
 			{
-				check(PreviousFuture.IsReady());
-				auto PrevExpected = PreviousFuture.Get();
+				bool bCanMove = false;
+				auto& PrevExpected = PreviousFuture.GetValueForContinuation(bCanMove);
 				if (PrevExpected.IsCompleted())
 				{
-					ContinuationPromise.SetValue(ContinuationFunction(*PrevExpected));
+					ContinuationPromise.SetValue(InvokeWithPreviousValue(ContinuationFunction, *PrevExpected, bCanMove));
 				}
 				else
 				{
@@ -218,8 +252,8 @@ namespace SD
 					TExpectedFuture<FutureType>& PreviousFuture,
 					TExpectedPromise<PromiseType>& ContinuationPromise)
 			{
-				check(PreviousFuture.IsReady());
-				auto PrevExpected = PreviousFuture.Get();
+				bool bCanMove = false;
+				const auto& PrevExpected = PreviousFuture.GetValueForContinuation(bCanMove);
 				if (PrevExpected.IsCompleted())
 				{
 					ContinuationPromise.SetValue(ContinuationFunction());
@@ -244,8 +278,9 @@ namespace SD
 					TExpectedFuture<FutureType>& PreviousFuture,
 					TExpectedPromise<PromiseType>& ContinuationPromise)
 			{
-				check(PreviousFuture.IsReady());
-				ContinuationFunction(PreviousFuture.Get());
+				bool bCanMove = false;
+				auto& PrevExpected = PreviousFuture.GetValueForContinuation(bCanMove);
+				InvokeWithPreviousValue(ContinuationFunction, PrevExpected, bCanMove);
 				ContinuationPromise.SetValue();
 			}
 
@@ -263,11 +298,11 @@ namespace SD
 					TExpectedFuture<FutureType>& PreviousFuture,
 					TExpectedPromise<PromiseType>& ContinuationPromise)
 			{
-				check(PreviousFuture.IsReady());
-				auto PrevExpected = PreviousFuture.Get();
+				bool bCanMove = false;
+				auto& PrevExpected = PreviousFuture.GetValueForContinuation(bCanMove);
 				if (PrevExpected.IsCompleted())
 				{
-					ContinuationFunction(*PrevExpected);
+					InvokeWithPreviousValue(ContinuationFunction, *PrevExpected, bCanMove);
 					ContinuationPromise.SetValue();
 				}
 				else
@@ -290,8 +325,8 @@ namespace SD
 					TExpectedFuture<FutureType>& PreviousFuture,
 					TExpectedPromise<PromiseType>& ContinuationPromise)
 			{
-				check(PreviousFuture.IsReady());
-				auto PrevExpected = PreviousFuture.Get();
+				bool bCanMove = false;
+				const auto& PrevExpected = PreviousFuture.GetValueForContinuation(bCanMove);
 				if (PrevExpected.IsCompleted())
 				{
 					ContinuationFunction();
@@ -305,7 +340,7 @@ namespace SD
 		}
 
 		inline void TryAddPromiseToCancellationHandle(WeakSharedCancellationHandlePtr WeakHandle,
-			const SharedCancellablePromiseRef& Promise)
+			const CancellablePromiseRef& Promise)
 		{
 			if (WeakHandle.IsValid())
 			{
@@ -319,80 +354,130 @@ namespace SD
 		template<typename F, typename R>
 		class TExpectedFutureInitTask : public FAsyncGraphTaskBase
 		{
-			using SharedPromiseRef = TSharedRef<TExpectedPromise<R>, ESPMode::ThreadSafe>;
 			using FFunctorType = TRemoveCVRef<F>;
 
 		public:
-			TExpectedFutureInitTask(F&& InFunc, const SharedPromiseRef& InPromise,
+			TExpectedFutureInitTask(F&& InFunc, TExpectedPromise<R>&& InPromise,
 				WeakSharedCancellationHandlePtr WeakCancellationHandle)
-				: SharedPromise(InPromise)
+				: Promise(MoveTemp(InPromise))
 				, InitFunctor(Forward<F>(InFunc))
 			{
-				TryAddPromiseToCancellationHandle(WeakCancellationHandle, SharedPromise);
+				//Its future has already been taken, and nothing else will take one from the task
+				Promise.SetWriteOnly();
+				TryAddPromiseToCancellationHandle(WeakCancellationHandle, Promise.GetCancellablePromise());
 			}
 
 			void DoTask(ENamedThreads::Type, const FGraphEventRef&)
 			{
-				if (!SharedPromise->IsSet())
+				if (!Promise.IsSet())
 				{
-					Details::ExecuteInitialFunction(MoveTemp(InitFunctor), *SharedPromise);
+					Details::ExecuteInitialFunction(MoveTemp(InitFunctor), Promise);
 				}
 			}
 
 			ENamedThreads::Type GetDesiredThread()
 			{
-				return SharedPromise->GetExecutionDetails().ExecutionThread;
+				return Promise.GetExecutionDetails().ExecutionThread;
 			}
 
 		private:
 
-			SharedPromiseRef SharedPromise;
+			TExpectedPromise<R> Promise;
 			FFunctorType InitFunctor;
 		};
 
 
+		/*
+		*	Graph task that runs a continuation on its desired thread once the antecedent has been set.
+		*	Only holds a pointer, so it stays within the task graph's small task allocator.
+		*/
+		template<typename TContinuation>
+		class TExpectedFutureContinuationGraphTask : public FAsyncGraphTaskBase
+		{
+		public:
+			explicit TExpectedFutureContinuationGraphTask(TContinuation* InContinuation)
+				: Continuation(InContinuation)
+			{
+			}
+
+			void DoTask(ENamedThreads::Type CurrentThread, const FGraphEventRef& MyCompletionGraphEvent)
+			{
+				Continuation->DoTask(CurrentThread, MyCompletionGraphEvent);
+				delete Continuation;
+			}
+
+			ENamedThreads::Type GetDesiredThread()
+			{
+				return Continuation->GetDesiredThread();
+			}
+
+		private:
+			TContinuation* Continuation;
+		};
+
 		template<typename F, typename P, typename R, typename TLifetimeMonitor>
-		class TExpectedFutureContinuationTask : public FAsyncGraphTaskBase
+		class TExpectedFutureContinuationTask : public FExpectedFutureContinuation
 		{
-			using SharedPromiseRef = TSharedRef<TExpectedPromise<R>, ESPMode::ThreadSafe>;
 			using FFunctorType = TRemoveCVRef<F>;
 
 		public:
-			TExpectedFutureContinuationTask(F&& InFunction, const SharedPromiseRef& InPromise,
+			TExpectedFutureContinuationTask(F&& InFunction, TExpectedPromise<R>&& InPromise,
 				const TExpectedFuture<P>& InPrevFuture,
 				WeakSharedCancellationHandlePtr WeakCancellationHandle,
 				TLifetimeMonitor&& InLifetimeMonitor)
-				: SharedPromise(InPromise)
+				: Promise(MoveTemp(InPromise))
 				, PrevFuture(InPrevFuture)
 				, ContinuationFunction(Forward<F>(InFunction))
 				, LifetimeMonitor(MoveTemp(InLifetimeMonitor))
 			{
-				TryAddPromiseToCancellationHandle(WeakCancellationHandle, SharedPromise);
+				Promise.SetWriteOnly();
+				TryAddPromiseToCancellationHandle(WeakCancellationHandle, Promise.GetCancellablePromise());
+			}
+
+			// Begin FExpectedFutureContinuation override
+			virtual void Schedule() override
+			{
+				if (Promise.GetExecutionDetails().ExecutionPolicy == EExpectedFutureExecutionPolicy::Inline)
+				{
+					FutureExecutionDetails::FInlineContinuationExecutor::Execute(this);
+				}
+				else
+				{
+					TGraphTask<TExpectedFutureContinuationGraphTask<TExpectedFutureContinuationTask>>::CreateTask()
+						.ConstructAndDispatchWhenReady(this);
+				}
+			}
+
+			virtual void Execute() override
+			{
+				DoTask(FTaskGraphInterface::Get().GetCurrentThreadIfKnown(), FGraphEventRef());
+				delete this;
 			}
+			// End FExpectedFutureContinuation override
 
 			void DoTask(ENamedThreads::Type CurrentThread, const FGraphEventRef& MyCompletionGraphEvent)
 			{
-				if (!SharedPromise->IsSet())
+				if (!Promise.IsSet())
 				{
 					if (auto PinnedObject = LifetimeMonitor.Pin())
 					{
-						Details::ExecuteContinuationFunction(MoveTemp(ContinuationFunction), PrevFuture, *SharedPromise);
+						Details::ExecuteContinuationFunction(MoveTemp(ContinuationFunction), PrevFuture, Promise);
 					}
 					else
 					{
-						SharedPromise->SetValue(SD::Error(Errors::ERROR_OBJECT_DESTROYED, TEXT("Lifetime Monitor Object could not be pinned")));
+						Promise.SetValue(SD::Error::Static(Errors::ERROR_OBJECT_DESTROYED, TEXT("Lifetime Monitor Object could not be pinned")));
 					}
 				}
 			}
 
 			ENamedThreads::Type GetDesiredThread()
 			{
-				return SharedPromise->GetExecutionDetails().ExecutionThread;
+				return Promise.GetExecutionDetails().ExecutionThread;
 			}
 
 		private:
 
-			SharedPromiseRef SharedPromise;
+			TExpectedPromise<R> Promise;
 			TExpectedFuture<P> PrevFuture;
 
 			FFunctorType ContinuationFunction;
@@ -401,22 +486,23 @@ namespace SD
 		};
 
 		template<typename R>
-		class TExpectedFutureQueuedWork : public IQueuedWork
+		class TExpectedFutureQueuedWork : public IQueuedWork, public FFutureAllocated
 		{
-			using SharedPromiseRef = TSharedRef<TExpectedPromise<R>, ESPMode::ThreadSafe>;
 
 		public:
-			TExpectedFutureQueuedWork(const SharedPromiseRef& InPromise,
+			TExpectedFutureQueuedWork(TExpectedPromise<R>&& InPromise,
 				WeakSharedCancellationHandlePtr WeakCancellationHandle)
-				: SharedPromise(InPromise)
+				: Promise(MoveTemp(InPromise))
 			{
+				Promise.SetWriteOnly();
+
 				//Task queued on a thread pool can be abandoned, which we conflate to cancellation.
 				//This requires them to always have a valid cancellation handle that we can use in this case.
 				//Create one if the promise doesn't already have one associated.
 				CancellationHandle = WeakCancellationHandle.IsValid()
 					? WeakCancellationHandle.Pin()
 					: CreateCancellationHandle();
-				TryAddPromiseToCancellationHandle(CancellationHandle, SharedPromise);
+				TryAddPromiseToCancellationHandle(CancellationHandle, Promise.GetCancellablePromise());
 			}
 
 			virtual ~TExpectedFutureQueuedWork() {}
@@ -424,17 +510,22 @@ namespace SD
 		protected:
 			virtual void DoWork() = 0;
 
-			SharedPromiseRef GetSharedPromise() const
+			TExpectedPromise<R>& GetPromise()
 			{
-				return SharedPromise;
+				return Promise;
+			}
+
+			void DoWorkAndFinalize()
+			{
+				DoWork();
+				Finalize();
 			}
 
 		private:
 			// Begin IQueuedWork override
 			virtual void DoThreadedWork() final
 			{
-				DoWork();
-				Finalize();
+				DoWorkAndFinalize();
 			}
 
 			virtual void Abandon() final
@@ -452,7 +543,7 @@ namespace SD
 			}
 
 		private:
-			SharedPromiseRef SharedPromise;
+			TExpectedPromise<R> Promise;
 			SharedCancellationHandlePtr CancellationHandle;
 		};
 
@@ -460,13 +551,12 @@ namespace SD
 		template<typename F, typename R>
 		class TExpectedFutureInitQueuedWork : public TExpectedFutureQueuedWork<R>
 		{
-			using SharedPromiseRef = TSharedRef<TExpectedPromise<R>, ESPMode::ThreadSafe>;
 			using FFunctorType = TRemoveCVRef<F>;
 
 		public:
-			TExpectedFutureInitQueuedWork(F&& InFunc, const SharedPromiseRef& InPromise,
+			TExpectedFutureInitQueuedWork(F&& InFunc, TExpectedPromise<R>&& InPromise,
 				WeakSharedCancellationHandlePtr WeakCancellationHandle)
-				: TExpectedFutureQueuedWork<R>(InPromise, WeakCancellationHandle)
+				: TExpectedFutureQueuedWork<R>(MoveTemp(InPromise), WeakCancellationHandle)
 				, InitFunctor(Forward<F>(InFunc))
 			{
 			}
@@ -476,10 +566,10 @@ namespace SD
 			// Begin TExpectedFutureQueuedWork override
 			virtual void DoWork() final
 			{
-				TExpectedFutureInitQueuedWork::SharedPromiseRef Promise = TExpectedFutureQueuedWork<R>::GetSharedPromise();
-				if (!Promise->IsSet())
+				TExpectedPromise<R>& Promise = TExpectedFutureQueuedWork<R>::GetPromise();
+				if (!Promise.IsSet())
 				{
-					Details::ExecuteInitialFunction(MoveTemp(InitFunctor), *Promise);
+					Details::ExecuteInitialFunction(MoveTemp(InitFunctor), Promise);
 				}
 			}
 			// End TExpectedFutureQueuedWork override
@@ -489,18 +579,24 @@ namespace SD
 			FFunctorType InitFunctor;
 		};
 
+		/*
+		*	Thread pool work for a continuation. It is only added to GThreadPool once the antecedent has been set,
+		*	so a pool worker never blocks waiting on an upstream future.
+		*/
 		template<typename F, typename P, typename R, typename TLifetimeMonitor>
-		class TExpectedFutureContinuationQueuedWork : public TExpectedFutureQueuedWork<R>
+		class TExpectedFutureContinuationQueuedWork : public TExpectedFutureQueuedWork<R>, public FExpectedFutureContinuation
 		{
-			using SharedPromiseRef = TSharedRef<TExpectedPromise<R>, ESPMode::ThreadSafe>;
 			using FFunctorType = TRemoveCVRef<F>;
 
 		public:
-			TExpectedFutureContinuationQueuedWork(F&& InFunction, const SharedPromiseRef& InPromise,
+			using TExpectedFutureQueuedWork<R>::operator new;
+			using TExpectedFutureQueuedWork<R>::operator delete;
+
+			TExpectedFutureContinuationQueuedWork(F&& InFunction, TExpectedPromise<R>&& InPromise,
 				const TExpectedFuture<P>& InPrevFuture,
 				WeakSharedCancellationHandlePtr WeakCancellationHandle,
 				TLifetimeMonitor&& InLifetimeMonitor)
-				: TExpectedFutureQueuedWork<R>(InPromise, WeakCancellationHandle)
+				: TExpectedFutureQueuedWork<R>(MoveTemp(InPromise), WeakCancellationHandle)
 				, PrevFuture(InPrevFuture)
 				, ContinuationFunction(Forward<F>(InFunction))
 				, LifetimeMonitor(MoveTemp(InLifetimeMonitor))
@@ -509,22 +605,31 @@ namespace SD
 
 			virtual ~TExpectedFutureContinuationQueuedWork() {}
 
+			// Begin FExpectedFutureContinuation override
+			virtual void Schedule() override
+			{
+				GThreadPool->AddQueuedWork(this);
+			}
+
+			virtual void Execute() override
+			{
+				TExpectedFutureQueuedWork<R>::DoWorkAndFinalize();
+			}
+			// End FExpectedFutureContinuation override
+
 			// Begin TExpectedFutureQueuedWork override
 			virtual void DoWork() final
 			{
-				TExpectedFutureContinuationQueuedWork::SharedPromiseRef Promise = TExpectedFutureQueuedWork<R>::GetSharedPromise();
-				if (!Promise->IsSet())
+				TExpectedPromise<R>& Promise = TExpectedFutureQueuedWork<R>::GetPromise();
+				if (!Promise.IsSet())
 				{
-					// We're running on a thread pool, so we can just wait on our previous future.
-					PrevFuture.Wait();
-
 					if (auto PinnedObject = LifetimeMonitor.Pin())
 					{
-						Details::ExecuteContinuationFunction(MoveTemp(ContinuationFunction), PrevFuture, *Promise);
+						Details::ExecuteContinuationFunction(MoveTemp(ContinuationFunction), PrevFuture, Promise);
 					}
 					else
 					{
-						Promise->SetValue(SD::Error(Errors::ERROR_OBJECT_DESTROYED, TEXT("Lifetime Monitor Object could not be pinned")));
+						Promise.SetValue(SD::Error::Static(Errors::ERROR_OBJECT_DESTROYED, TEXT("Lifetime Monitor Object could not be pinned")));
 					}
 				}
 			}
@@ -6,4 +6,9 @@
 #include "ExpectedFutureOptions.h"
 #include "ExpectedFuture.h"
 #include "FutureExtensionTaskGraph.h"
-#include "FutureExtensionsStaticFuncs.h"
\ No newline at end of file
+#include "FutureExtensionsStaticFuncs.h"
+#include "SingleFlight.h"
+#include "ExpectedFutureCache.h"
+#include "ExpectedStream.h"
+#include "Channel.h"
+#include "AsyncLock.h"
\ No newline at end of file
@@ -1,10 +1,14 @@
 // Copyright(c) Splash Damage. All rights reserved.
 #pragma once
 #include <atomic>
+#include <utility>
 
 #include "ExpectedResult.h"
 #include "ExpectedFuture.h"
 #include "FutureExtensionTaskGraph.h"
+#include "Containers/Map.h"
+#include "Containers/Ticker.h"
+#include "Templates/Function.h"
 
 namespace SD
 {
@@ -14,60 +18,169 @@ namespace SD
 		Fast
 	};
 
+	namespace Details
+	{
+		template<typename T>
+		class TWhenAllSettledState;
+	}
+
 	template<typename F>
 	auto Async(F&& Function, const SD::FExpectedFutureOptions& FutureOptions = SD::FExpectedFutureOptions())
 	{
 		return FutureInitialisationDetails::CreateExpectedFuture(Forward<F>(Function), FutureOptions);
 	}
 
-	template<typename T>
-	SD::TExpectedFuture<TArray<T>> WhenAll(const TArray<SD::TExpectedFuture<T>>& Futures, const EFailMode FailMode)
+	namespace Details
 	{
-		if (Futures.Num() == 0)
+		/*
+		*	Shared by all the continuations of a WhenAll. Every antecedent counts down once, and whichever is last
+		*	completes the promise. Only the first failure is kept; with EFailMode::Fast it completes the promise straight
+		*	away instead.
+		*/
+		template<typename R>
+		class TWhenAllState
 		{
-			return MakeReadyFuture<TArray<T>>(TArray<T>());
-		}
+		public:
+			using ResultType = R;
 
-		const auto CounterRef = MakeShared<std::atomic<int32>, ESPMode::ThreadSafe>(Futures.Num());
-		const auto PromiseRef = MakeShared<SD::TExpectedPromise<TArray<T>>, ESPMode::ThreadSafe>();
-		const auto ValueRef = MakeShared<TArray<T>, ESPMode::ThreadSafe>();
-		const auto FirstErrorRef = MakeShared<SD::TExpectedPromise<TArray<T>>, ESPMode::ThreadSafe>();
+			TWhenAllState(const int32 NumFutures, const EFailMode InFailMode)
+				: NumRemaining(NumFutures)
+				, FailMode(InFailMode)
+			{}
+
+			TExpectedFuture<R> GetFuture()
+			{
+				return Promise.GetFuture();
+			}
+
+			//Set early by a fast failure or by cancelling the promise, in which case the remaining results are unused
+			bool IsFinished() const
+			{
+				return Promise.IsSet();
+			}
+
+			CancellablePromiseRef GetCancellablePromise() const
+			{
+				return Promise.GetCancellablePromise();
+			}
+
+			void OnFailed(TExpected<R>&& Failure)
+			{
+				bool bAlreadyFailed = false;
+				if (!bFailed.compare_exchange_strong(bAlreadyFailed, true, std::memory_order_relaxed))
+				{
+					return;
+				}
+
+				if (FailMode == EFailMode::Fast)
+				{
+					Promise.SetValue(MoveTemp(Failure));
+				}
+				else
+				{
+					//Read by the last antecedent, which is ordered after this by the countdown
+					FirstFailure = MoveTemp(Failure);
+				}
+			}
 
-		const auto SetPromise = [FirstErrorRef, PromiseRef]()
+			//Returns true for the last antecedent to finish, which must then call Complete()
+			bool OnAntecedentDone()
+			{
+				return NumRemaining.fetch_sub(1, std::memory_order_acq_rel) == 1;
+			}
+
+			//MakeValue is only called if every antecedent succeeded
+			template<typename ValueFactoryType>
+			void Complete(ValueFactoryType&& MakeValue)
+			{
+				if (!bFailed.load(std::memory_order_relaxed))
+				{
+					Promise.SetValue(MakeValue());
+				}
+				else if (FailMode != EFailMode::Fast)
+				{
+					Promise.SetValue(MoveTemp(FirstFailure));
+				}
+			}
+
+		private:
+			TExpectedPromise<R> Promise;
+			std::atomic<int32> NumRemaining;
+			std::atomic<bool> bFailed{ false };
+			const EFailMode FailMode;
+			TExpected<R> FirstFailure;
+		};
+
+		//Each antecedent writes to its own slot, so results keep the order of the input array
+		template<typename T>
+		class TWhenAllValuesState : public TWhenAllState<TArray<T>>
 		{
-			FirstErrorRef->GetFuture().Then([PromiseRef](SD::TExpected<TArray<T>> Result) {PromiseRef->SetValue(MoveTemp(Result)); });
+		public:
+			TWhenAllValuesState(const int32 NumFutures, const EFailMode InFailMode)
+				: TWhenAllState<TArray<T>>(NumFutures, InFailMode)
+			{
+				Slots.SetNum(NumFutures);
+			}
+
+			void OnSucceeded(const int32 Index, T&& Value)
+			{
+				Slots[Index].Emplace(MoveTemp(Value));
+			}
+
+			TArray<T> TakeValues()
+			{
+				TArray<T> Values;
+				Values.Reserve(Slots.Num());
+				for (TOptional<T>& Slot : Slots)
+				{
+					Values.Add(MoveTemp(Slot.GetValue()));
+				}
+				return Values;
+			}
+
+		private:
+			TArray<TOptional<T>> Slots;
 		};
+	}
 
-		if (FailMode == EFailMode::Fast)
+	/*
+	*	Completes once every future has, with their values in the same order as Futures. Fails with the first error
+	*	(or cancellation) among them, either as soon as it happens (EFailMode::Fast) or once they are all done (Full).
+	*/
+	template<typename T>
+	SD::TExpectedFuture<TArray<T>> WhenAll(const TArray<SD::TExpectedFuture<T>>& Futures, const EFailMode FailMode)
+	{
+		if (Futures.Num() == 0)
 		{
-			SetPromise();
+			return MakeReadyFuture<TArray<T>>(TArray<T>());
 		}
 
-		for (const auto& Future : Futures)
+		using FState = Details::TWhenAllValuesState<T>;
+		const auto State = MakeShared<FState, ESPMode::ThreadSafe>(Futures.Num(), FailMode);
+
+		//Only records the result, so there is no need to schedule a task for it
+		const FExpectedFutureOptions InlineOptions(EExpectedFutureExecutionPolicy::Inline);
+
+		for (int32 Index = 0; Index < Futures.Num(); ++Index)
 		{
-			Future.Then([CounterRef, ValueRef, FirstErrorRef, SetPromise, FailMode](const SD::TExpected<T>& Result)
+			Futures[Index].Then([State, Index](SD::TExpected<T> Result)
 				{
 					if (Result.IsCompleted())
 					{
-						ValueRef->Emplace(*Result);
+						State->OnSucceeded(Index, MoveTemp(*Result));
 					}
 					else
 					{
-						FirstErrorRef->SetValue(Convert<TArray<T>, T>(Result, TArray<T>()));
+						State->OnFailed(ConvertIncomplete<TArray<T>>(Result));
 					}
 
-					if (--(CounterRef.Get()) == 0)
+					if (State->OnAntecedentDone())
 					{
-						FirstErrorRef->SetValue(ValueRef.Get());
-
-						if (FailMode != EFailMode::Fast)
-						{
-							SetPromise();
-						}
+						State->Complete([&State]() { return State->TakeValues(); });
 					}
-				});
+				}, InlineOptions);
 		}
-		return PromiseRef->GetFuture();
+		return State->GetFuture();
 	}
 
 	template<typename T>
@@ -76,23 +189,1338 @@ namespace SD
 	SDFUTUREEXTENSIONS_API SD::TExpectedFuture<void> WhenAll(const TArray<SD::TExpectedFuture<void>>& Futures, const EFailMode FailMode);
 	SDFUTUREEXTENSIONS_API SD::TExpectedFuture<void> WhenAll(const TArray<SD::TExpectedFuture<void>>& Futures);
 
+	namespace Details
+	{
+		template<typename... Ts>
+		class TWhenAllTupleState : public TWhenAllState<TTuple<Ts...>>
+		{
+		public:
+			explicit TWhenAllTupleState(const EFailMode InFailMode)
+				: TWhenAllState<TTuple<Ts...>>(sizeof...(Ts), InFailMode)
+			{}
+
+			template<SIZE_T Index, typename T>
+			void OnSucceeded(T&& Value)
+			{
+				Slots.template Get<Index>().Emplace(MoveTemp(Value));
+			}
+
+			TTuple<Ts...> TakeValues()
+			{
+				return TakeValues(std::index_sequence_for<Ts...>());
+			}
+
+		private:
+			template<SIZE_T... Indices>
+			TTuple<Ts...> TakeValues(std::index_sequence<Indices...>)
+			{
+				return TTuple<Ts...>(MoveTemp(Slots.template Get<Indices>().GetValue())...);
+			}
+
+			TTuple<TOptional<Ts>...> Slots;
+		};
+
+		template<SIZE_T Index, typename StateType, typename T>
+		void AddWhenAllTupleContinuation(const TSharedRef<StateType, ESPMode::ThreadSafe>& State, const TExpectedFuture<T>& Future)
+		{
+			Future.Then([State](SD::TExpected<T> Result)
+				{
+					if (Result.IsCompleted())
+					{
+						State->template OnSucceeded<Index>(MoveTemp(*Result));
+					}
+					else
+					{
+						State->OnFailed(ConvertIncomplete<typename StateType::ResultType>(Result));
+					}
+
+					if (State->OnAntecedentDone())
+					{
+						State->Complete([&State]() { return State->TakeValues(); });
+					}
+				}, FExpectedFutureOptions(EExpectedFutureExecutionPolicy::Inline));
+		}
+
+		template<typename... Ts, SIZE_T... Indices>
+		TExpectedFuture<TTuple<Ts...>> WhenAllTuple(const EFailMode FailMode, std::index_sequence<Indices...>, const TExpectedFuture<Ts>&... Futures)
+		{
+			static_assert(!std::disjunction<std::is_void<Ts>...>::value, "SD::WhenAll - Futures combined into a tuple cannot be void, use the TArray overload or Convert them first.");
+
+			const auto State = MakeShared<TWhenAllTupleState<Ts...>, ESPMode::ThreadSafe>(FailMode);
+			(AddWhenAllTupleContinuation<Indices>(State, Futures), ...);
+			return State->GetFuture();
+		}
+	}
+
+	/*
+	*	Combines futures of different types into a tuple of their values, in the same order as the arguments.
+	*	Fails in the same way as the TArray overloads.
+	*/
+	template<typename T1, typename T2, typename... Ts>
+	SD::TExpectedFuture<TTuple<T1, T2, Ts...>> WhenAll(const EFailMode FailMode, const SD::TExpectedFuture<T1>& Future1, const SD::TExpectedFuture<T2>& Future2, const SD::TExpectedFuture<Ts>&... Futures)
+	{
+		return Details::WhenAllTuple<T1, T2, Ts...>(FailMode, std::index_sequence_for<T1, T2, Ts...>(), Future1, Future2, Futures...);
+	}
+
+	template<typename T1, typename T2, typename... Ts>
+	SD::TExpectedFuture<TTuple<T1, T2, Ts...>> WhenAll(const SD::TExpectedFuture<T1>& Future1, const SD::TExpectedFuture<T2>& Future2, const SD::TExpectedFuture<Ts>&... Futures)
+	{
+		return WhenAll(EFailMode::Full, Future1, Future2, Futures...);
+	}
+
 	template<typename T>
 	SD::TExpectedFuture<T> WhenAny(const TArray<SD::TExpectedFuture<T>>& Futures)
 	{
 		if (Futures.Num() == 0)
 		{
-			return SD::MakeErrorFuture<T>(Error(Errors::ERROR_INVALID_ARGUMENT, TEXT("SD::WhenAny - Must have at least one element in the array.")));
+			return SD::MakeErrorFuture<T>(Error::Static(Errors::ERROR_INVALID_ARGUMENT, TEXT("SD::WhenAny - Must have at least one element in the array.")));
 		}
-		auto PromiseRef = MakeShared<SD::TExpectedPromise<T>, ESPMode::ThreadSafe>();
+		SD::TExpectedPromise<T> Promise;
 		for (auto& Future : Futures)
 		{
-			Future.Then([PromiseRef](const SD::TExpected<T>& Result)
+			Future.Then([Promise](const SD::TExpected<T>& Result) mutable
 				{
-					PromiseRef->SetValue(SD::TExpected<T>(Result));
+					Promise.SetValue(SD::TExpected<T>(Result));
 				});
 		}
-		return PromiseRef->GetFuture();
+		return Promise.GetFuture();
+	}
+
+	namespace Details
+	{
+		/*
+		*	The whole join state of a WhenN is one atomic word with three counters:
+		*	- Claimed: successes so far. The first NumRequired of them each claim their own value slot.
+		*	- Committed: claimed slots that have been written. Whoever commits the last one completes the promise.
+		*	- Failed: failures so far. Whoever makes success impossible completes the promise with their error.
+		*/
+		template<typename T>
+		class TWhenNState
+		{
+		public:
+			static constexpr int32 CounterBits = 21;
+			static constexpr int32 MaxFutures = (1 << CounterBits) - 1;
+
+			TWhenNState(const int32 InNumFutures, const int32 InNumRequired, const TArray<SharedCancellationHandleRef>& InCancellationHandles)
+				: NumRequired(InNumRequired)
+				, MaxFailures(InNumFutures - InNumRequired)
+				, CancellationHandles(InCancellationHandles)
+			{
+				Slots.SetNum(NumRequired);
+			}
+
+			TExpectedFuture<TArray<T>> GetFuture()
+			{
+				return Promise.GetFuture();
+			}
+
+			void OnCompleted(TExpected<T>&& Result)
+			{
+				if (Result.IsCompleted())
+				{
+					const int32 Slot = GetCounter(Counters.fetch_add(ClaimedUnit, std::memory_order_relaxed), ClaimedShift);
+					if (Slot >= NumRequired)
+					{
+						return;
+					}
+
+					Slots[Slot].Emplace(MoveTemp(*Result));
+
+					const int32 NumCommitted = GetCounter(Counters.fetch_add(CommittedUnit, std::memory_order_acq_rel), CommittedShift) + 1;
+					if (NumCommitted == NumRequired)
+					{
+						Complete(TakeValues());
+					}
+				}
+				else
+				{
+					const int32 NumFailed = GetCounter(Counters.fetch_add(FailedUnit, std::memory_order_relaxed), FailedShift) + 1;
+					if (NumFailed == MaxFailures + 1)
+					{
+						Complete(ConvertIncomplete<TArray<T>>(Result));
+					}
+				}
+			}
+
+		private:
+			static constexpr int32 ClaimedShift = 0;
+			static constexpr int32 CommittedShift = CounterBits;
+			static constexpr int32 FailedShift = CounterBits * 2;
+
+			static constexpr uint64 ClaimedUnit = uint64(1) << ClaimedShift;
+			static constexpr uint64 CommittedUnit = uint64(1) << CommittedShift;
+			static constexpr uint64 FailedUnit = uint64(1) << FailedShift;
+
+			static int32 GetCounter(const uint64 Counters, const int32 Shift)
+			{
+				return static_cast<int32>((Counters >> Shift) & MaxFutures);
+			}
+
+			TArray<T> TakeValues()
+			{
+				TArray<T> Values;
+				Values.Reserve(Slots.Num());
+				for (TOptional<T>& Slot : Slots)
+				{
+					Values.Add(MoveTemp(Slot.GetValue()));
+				}
+				return Values;
+			}
+
+			//Only ever called once, as K successes and N-K+1 failures cannot both happen
+			void Complete(TExpected<TArray<T>>&& Result)
+			{
+				Promise.SetValue(MoveTemp(Result));
+
+				for (const SharedCancellationHandleRef& CancellationHandle : CancellationHandles)
+				{
+					CancellationHandle->Cancel();
+				}
+				CancellationHandles.Empty();
+			}
+
+			TExpectedPromise<TArray<T>> Promise;
+			TArray<TOptional<T>> Slots;
+			std::atomic<uint64> Counters{ 0 };
+			const int32 NumRequired;
+			const int32 MaxFailures;
+			TArray<SharedCancellationHandleRef> CancellationHandles;
+		};
+	}
+
+	/*
+	*	Completes as soon as NumRequired of the futures have succeeded, with their values in the order they succeeded.
+	*	Fails as soon as that becomes impossible, with the error of the future that made it so. If CancellationHandles
+	*	are given (one per future, or none), all of them are cancelled once the result is known so stragglers are skipped.
+	*/
+	template<typename T>
+	SD::TExpectedFuture<TArray<T>> WhenN(const TArray<SD::TExpectedFuture<T>>& Futures, const int32 NumRequired, const TArray<SharedCancellationHandleRef>& CancellationHandles = {})
+	{
+		using FState = Details::TWhenNState<T>;
+
+		if (NumRequired < 0 || NumRequired > Futures.Num() || Futures.Num() > FState::MaxFutures
+			|| (CancellationHandles.Num() != 0 && CancellationHandles.Num() != Futures.Num()))
+		{
+			return SD::MakeErrorFuture<TArray<T>>(Error::Static(Errors::ERROR_INVALID_ARGUMENT, TEXT("SD::WhenN - Must require between 0 and the number of futures, with either no cancellation handles or one for each.")));
+		}
+
+		if (NumRequired == 0)
+		{
+			return MakeReadyFuture<TArray<T>>(TArray<T>());
+		}
+
+		const auto State = MakeShared<FState, ESPMode::ThreadSafe>(Futures.Num(), NumRequired, CancellationHandles);
+		for (const SD::TExpectedFuture<T>& Future : Futures)
+		{
+			Future.Then([State](SD::TExpected<T> Result)
+				{
+					State->OnCompleted(MoveTemp(Result));
+				}, FExpectedFutureOptions(EExpectedFutureExecutionPolicy::Inline));
+		}
+		return State->GetFuture();
+	}
+
+	//Number of WhenAllSettled results in each state, so partial failures can be reported without scanning the results
+	class FWhenAllSettledSummary
+	{
+	public:
+		int32 GetNum(const EExpectedResultState State) const
+		{
+			return NumByState[static_cast<uint8>(State)];
+		}
+
+		bool HasFailures() const
+		{
+			return GetNum(EExpectedResultState::Error) > 0 || GetNum(EExpectedResultState::Cancelled) > 0;
+		}
+
+	private:
+		template<typename T>
+		friend class Details::TWhenAllSettledState;
+
+		static constexpr int32 NumStates = static_cast<int32>(EExpectedResultState::Error) + 1;
+		int32 NumByState[NumStates] = {};
+	};
+
+	template<typename T>
+	struct TWhenAllSettledResult
+	{
+		//Same order as the futures given to WhenAllSettled
+		TArray<TExpected<T>> Results;
+		FWhenAllSettledSummary Summary;
+	};
+
+	namespace Details
+	{
+		template<typename T>
+		class TWhenAllSettledState
+		{
+		public:
+			explicit TWhenAllSettledState(const int32 NumFutures)
+				: NumRemaining(NumFutures)
+			{
+				Results.SetNum(NumFutures);
+			}
+
+			TExpectedFuture<TWhenAllSettledResult<T>> GetFuture()
+			{
+				return Promise.GetFuture();
+			}
+
+			void OnSettled(const int32 Index, TExpected<T>&& Result)
+			{
+				NumByState[static_cast<uint8>(Result.GetState())].fetch_add(1, std::memory_order_relaxed);
+				Results[Index] = MoveTemp(Result);
+
+				//The last result to settle sees every other slot, as they were all written before counting down
+				if (NumRemaining.fetch_sub(1, std::memory_order_acq_rel) == 1)
+				{
+					TWhenAllSettledResult<T> Settled;
+					Settled.Results = MoveTemp(Results);
+					for (int32 State = 0; State < FWhenAllSettledSummary::NumStates; ++State)
+					{
+						Settled.Summary.NumByState[State] = NumByState[State].load(std::memory_order_relaxed);
+					}
+					Promise.SetValue(MoveTemp(Settled));
+				}
+			}
+
+		private:
+			TExpectedPromise<TWhenAllSettledResult<T>> Promise;
+			TArray<TExpected<T>> Results;
+			std::atomic<int32> NumRemaining;
+			std::atomic<int32> NumByState[FWhenAllSettledSummary::NumStates] = {};
+		};
+	}
+
+	/*
+	*	Completes once every future has, with all of their results (values, errors and cancellations alike) in the same
+	*	order as Futures. Never fails itself.
+	*/
+	template<typename T>
+	SD::TExpectedFuture<TWhenAllSettledResult<T>> WhenAllSettled(const TArray<SD::TExpectedFuture<T>>& Futures)
+	{
+		if (Futures.Num() == 0)
+		{
+			return MakeReadyFuture<TWhenAllSettledResult<T>>(TWhenAllSettledResult<T>());
+		}
+
+		const auto State = MakeShared<Details::TWhenAllSettledState<T>, ESPMode::ThreadSafe>(Futures.Num());
+		for (int32 Index = 0; Index < Futures.Num(); ++Index)
+		{
+			Futures[Index].Then([State, Index](SD::TExpected<T> Result)
+				{
+					State->OnSettled(Index, MoveTemp(Result));
+				}, FExpectedFutureOptions(EExpectedFutureExecutionPolicy::Inline));
+		}
+		return State->GetFuture();
+	}
+
+	//Result of WhenAnyCancelOthers, with the index of the future that completed first
+	template<typename T>
+	struct TWhenAnyResult
+	{
+		int32 Index = INDEX_NONE;
+		T Value;
+	};
+
+	template<>
+	struct TWhenAnyResult<void>
+	{
+		int32 Index = INDEX_NONE;
+	};
+
+	namespace Details
+	{
+		template<typename T>
+		class TWhenAnyCancelOthersState
+		{
+		public:
+			explicit TWhenAnyCancelOthersState(const TArray<SharedCancellationHandleRef>& InCancellationHandles)
+				: CancellationHandles(InCancellationHandles)
+			{}
+
+			TExpectedFuture<TWhenAnyResult<T>> GetFuture()
+			{
+				return Promise.GetFuture();
+			}
+
+			void OnCompleted(const int32 Index, TExpected<T>&& Result)
+			{
+				bool bAlreadyCompleted = false;
+				if (!bCompleted.compare_exchange_strong(bAlreadyCompleted, true, std::memory_order_acq_rel))
+				{
+					return;
+				}
+
+				if (Result.IsCompleted())
+				{
+					Promise.SetValue(MakeResult(Index, MoveTemp(Result)));
+				}
+				else
+				{
+					Promise.SetValue(ConvertIncomplete<TWhenAnyResult<T>>(Result));
+				}
+
+				//Only the winner gets here, so nothing else reads the handles any more
+				for (int32 OtherIndex = 0; OtherIndex < CancellationHandles.Num(); ++OtherIndex)
+				{
+					if (OtherIndex != Index)
+					{
+						CancellationHandles[OtherIndex]->Cancel();
+					}
+				}
+				CancellationHandles.Empty();
+			}
+
+		private:
+			template<typename ValueType>
+			static TWhenAnyResult<ValueType> MakeResult(const int32 Index, TExpected<ValueType>&& Result)
+			{
+				return TWhenAnyResult<ValueType>{ Index, MoveTemp(*Result) };
+			}
+
+			static TWhenAnyResult<void> MakeResult(const int32 Index, TExpected<void>&& Result)
+			{
+				return TWhenAnyResult<void>{ Index };
+			}
+
+			TExpectedPromise<TWhenAnyResult<T>> Promise;
+			TArray<SharedCancellationHandleRef> CancellationHandles;
+			std::atomic<bool> bCompleted{ false };
+		};
+	}
+
+	/*
+	*	Like WhenAny, but once the first future completes every other one is cancelled through its cancellation handle,
+	*	so work that has not started yet is skipped. Each future must have been created with the handle at the same
+	*	index in CancellationHandles.
+	*/
+	template<typename T>
+	SD::TExpectedFuture<TWhenAnyResult<T>> WhenAnyCancelOthers(const TArray<SD::TExpectedFuture<T>>& Futures, const TArray<SharedCancellationHandleRef>& CancellationHandles)
+	{
+		if (Futures.Num() == 0 || Futures.Num() != CancellationHandles.Num())
+		{
+			return SD::MakeErrorFuture<TWhenAnyResult<T>>(Error::Static(Errors::ERROR_INVALID_ARGUMENT, TEXT("SD::WhenAnyCancelOthers - Must have at least one element in the array, and a cancellation handle for each.")));
+		}
+
+		const auto State = MakeShared<Details::TWhenAnyCancelOthersState<T>, ESPMode::ThreadSafe>(CancellationHandles);
+		for (int32 Index = 0; Index < Futures.Num(); ++Index)
+		{
+			Futures[Index].Then([State, Index](SD::TExpected<T> Result)
+				{
+					State->OnCompleted(Index, MoveTemp(Result));
+				}, FExpectedFutureOptions(EExpectedFutureExecutionPolicy::Inline));
+		}
+		return State->GetFuture();
+	}
+
+	/*
+	*	Creates a cancellation handle for each of NumFutures futures, which StartFuture should pass on to the work it starts:
+	*	SD::TExpectedFuture<T> StartFuture(int32 Index, const SD::SharedCancellationHandleRef& CancellationHandle)
+	*/
+	template<typename F>
+	auto WhenAnyCancelOthers(const int32 NumFutures, F&& StartFuture)
+	{
+		using FutureType = std::decay_t<decltype(StartFuture(0, CreateCancellationHandle()))>;
+		static_assert(FutureExtensionTypeTraits::TIsExpectedFuture<FutureType>::value, "SD::WhenAnyCancelOthers - StartFuture must return a TExpectedFuture.");
+
+		TArray<FutureType> Futures;
+		TArray<SharedCancellationHandleRef> CancellationHandles;
+		Futures.Reserve(NumFutures);
+		CancellationHandles.Reserve(NumFutures);
+
+		for (int32 Index = 0; Index < NumFutures; ++Index)
+		{
+			CancellationHandles.Add(CreateCancellationHandle());
+			Futures.Add(StartFuture(Index, CancellationHandles.Last()));
+		}
+
+		return WhenAnyCancelOthers<typename FutureType::ResultType>(Futures, CancellationHandles);
+	}
+
+	namespace Details
+	{
+		struct SDFUTUREEXTENSIONS_API FParallelChunking
+		{
+			//Enough chunks per worker to even out items that take different amounts of time
+			static constexpr int32 ChunksPerWorker = 4;
+
+			//Chunks shorter than this spend a noticeable share of their time being scheduled
+			static constexpr double MinChunkSeconds = 0.0002;
+
+			//Number of threads the chunks can run on concurrently with the given execution policy
+			static int32 GetNumWorkers(const FExpectedFutureOptions& Options);
+
+			//Items to time on the first task before splitting the rest, at most one balanced chunk's worth
+			static int32 GetMaxPilotItems(const int32 NumItems, const int32 NumWorkers);
+
+			static int32 GetChunkSize(const int32 NumItems, const int32 NumWorkers, const double SecondsPerItem);
+		};
+
+		/*
+		*	Owns the input, the function and (for ParallelMap) the pre-sized output, which every chunk writes to in place.
+		*	Chunks cover disjoint ranges, so they never touch the same element.
+		*/
+		template<typename T, typename F, typename R>
+		class TParallelState
+		{
+			//Unused placeholder for ParallelForEach, which has no output
+			using OutputType = typename std::conditional<std::is_void<R>::value, int32, R>::type;
+
+		public:
+			TParallelState(TArray<T>&& InInput, F&& InFunc)
+				: Input(MoveTemp(InInput))
+				, Func(MoveTemp(InFunc))
+			{
+				if constexpr (!std::is_void<R>::value)
+				{
+					Output.SetNum(Input.Num());
+				}
+			}
+
+			int32 Num() const
+			{
+				return Input.Num();
+			}
+
+			void Run(const int32 Begin, const int32 End)
+			{
+				for (int32 Index = Begin; Index < End; ++Index)
+				{
+					if constexpr (std::is_void<R>::value)
+					{
+						Func(Input[Index]);
+					}
+					else
+					{
+						Output[Index] = Func(Input[Index]);
+					}
+				}
+			}
+
+			//Runs items from the start in doubling batches until they have taken long enough to time. Returns how many ran.
+			int32 RunPilot(const int32 MaxItems, double& OutSeconds)
+			{
+				const double StartTime = FPlatformTime::Seconds();
+				int32 NumRun = 0;
+				int32 BatchSize = 1;
+
+				OutSeconds = 0.0;
+				while (NumRun < MaxItems && OutSeconds < FParallelChunking::MinChunkSeconds)
+				{
+					const int32 End = FMath::Min(NumRun + BatchSize, MaxItems);
+					Run(NumRun, End);
+					NumRun = End;
+					BatchSize *= 2;
+					OutSeconds = FPlatformTime::Seconds() - StartTime;
+				}
+				return NumRun;
+			}
+
+			TArray<OutputType> TakeOutput()
+			{
+				return MoveTemp(Output);
+			}
+
+		private:
+			TArray<T> Input;
+			F Func;
+			TArray<OutputType> Output;
+		};
+
+		template<typename StateType>
+		TExpectedFuture<void> RunParallel(const TSharedRef<StateType, ESPMode::ThreadSafe>& State, const FExpectedFutureOptions& Options)
+		{
+			//The first task times some items to size the chunks for the rest, which then run concurrently
+			return SD::Async([State, Options]()
+			{
+				const int32 NumItems = State->Num();
+				const int32 NumWorkers = FParallelChunking::GetNumWorkers(Options);
+
+				double PilotSeconds = 0.0;
+				const int32 NumPiloted = State->RunPilot(FParallelChunking::GetMaxPilotItems(NumItems, NumWorkers), PilotSeconds);
+				if (NumPiloted == NumItems)
+				{
+					return MakeReadyFuture();
+				}
+
+				const int32 ChunkSize = FParallelChunking::GetChunkSize(NumItems - NumPiloted, NumWorkers, PilotSeconds / NumPiloted);
+
+				//Chunks share the cancellation handle, so ones that have not started are skipped once it is cancelled
+				TArray<TExpectedFuture<void>> Chunks;
+				Chunks.Reserve((NumItems - NumPiloted + ChunkSize - 1) / ChunkSize);
+				for (int32 Begin = NumPiloted; Begin < NumItems; Begin += ChunkSize)
+				{
+					const int32 End = FMath::Min(Begin + ChunkSize, NumItems);
+					Chunks.Add(SD::Async([State, Begin, End]()
+					{
+						State->Run(Begin, End);
+					}, Options));
+				}
+				return WhenAll(Chunks, EFailMode::Fast);
+			}, Options);
+		}
+	}
+
+	/*
+	*	Calls Func on every element of Input, splitting them into chunks that run with the given execution policy, and
+	*	completes with the results in the same order. Chunks are sized from the number of workers and the time taken by
+	*	the first few items, rather than scheduling a task per element. Results are written in place, so R must be
+	*	default constructible.
+	*/
+	template<typename T, typename F>
+	auto ParallelMap(TArray<T> Input, F&& Func, const FExpectedFutureOptions& Options = FExpectedFutureOptions())
+	{
+		using R = std::decay_t<decltype(Func(std::declval<const T&>()))>;
+		static_assert(!std::is_void<R>::value, "SD::ParallelMap - Func must return a value, use ParallelForEach otherwise.");
+		static_assert(std::is_default_constructible<R>::value, "SD::ParallelMap - Results must be default constructible.");
+
+		if (Input.Num() == 0)
+		{
+			return MakeReadyFuture<TArray<R>>(TArray<R>());
+		}
+
+		using FState = Details::TParallelState<T, std::decay_t<F>, R>;
+		const auto State = MakeShared<FState, ESPMode::ThreadSafe>(MoveTemp(Input), std::decay_t<F>(Forward<F>(Func)));
+
+		return Details::RunParallel(State, Options).Then([State]()
+		{
+			return State->TakeOutput();
+		}, FExpectedFutureOptions(EExpectedFutureExecutionPolicy::Inline));
+	}
+
+	//ParallelMap for functions that do not return anything
+	template<typename T, typename F>
+	SD::TExpectedFuture<void> ParallelForEach(TArray<T> Input, F&& Func, const FExpectedFutureOptions& Options = FExpectedFutureOptions())
+	{
+		if (Input.Num() == 0)
+		{
+			return MakeReadyFuture();
+		}
+
+		using FState = Details::TParallelState<T, std::decay_t<F>, void>;
+		const auto State = MakeShared<FState, ESPMode::ThreadSafe>(MoveTemp(Input), std::decay_t<F>(Forward<F>(Func)));
+
+		return Details::RunParallel(State, Options);
+	}
+
+	enum class EReduceOrder
+	{
+		//Only combines neighbouring results, in a balanced tree over the input order. Combine only has to be associative.
+		Ordered,
+
+		//Combines whichever two results are available first. Combine has to be associative and commutative.
+		Unordered
+	};
+
+	namespace Details
+	{
+		/*
+		*	Only values that are waiting for the one they are combined with are kept, so memory stays bounded by the
+		*	number of futures in flight rather than the number of inputs. Combines are scheduled as soon as both of their
+		*	values are available, and their result is fed back in like any other value.
+		*/
+		template<typename T, typename F>
+		class TReduceState : public TSharedFromThis<TReduceState<T, F>, ESPMode::ThreadSafe>
+		{
+		public:
+			TReduceState(const int32 InNumFutures, F&& InCombine, const FExpectedFutureOptions& InOptions, const EReduceOrder InOrder)
+				: Combine(MoveTemp(InCombine))
+				, Options(InOptions)
+				, Order(InOrder)
+				, NumFutures(InNumFutures)
+				, NumRemaining(InNumFutures)
+			{}
+
+			TExpectedFuture<T> GetFuture()
+			{
+				return Promise.GetFuture();
+			}
+
+			void OnValue(int32 Level, int32 Index, T&& Value)
+			{
+				TOptional<T> Other;
+				bool bOtherIsLeft = false;
+				{
+					FScopeLock Lock(&CriticalSection);
+					if (bFinished)
+					{
+						return;
+					}
+
+					if (NumRemaining == 1)
+					{
+						bFinished = true;
+					}
+					else if (Order == EReduceOrder::Unordered)
+					{
+						if (!Unordered.IsSet())
+						{
+							Unordered.Emplace(MoveTemp(Value));
+							return;
+						}
+
+						Other.Emplace(MoveTemp(Unordered.GetValue()));
+						Unordered.Reset();
+					}
+					else
+					{
+						//A node without a sibling is passed straight up to the next level
+						while ((Index ^ 1) >= GetLevelSize(Level))
+						{
+							++Level;
+							Index /= 2;
+						}
+
+						const uint64 ParentKey = GetNodeKey(Level + 1, Index / 2);
+						if (FPendingNode* Sibling = Pending.Find(ParentKey))
+						{
+							Other.Emplace(MoveTemp(Sibling->Value));
+							bOtherIsLeft = Sibling->bIsLeft;
+							Pending.Remove(ParentKey);
+						}
+						else
+						{
+							Pending.Add(ParentKey, FPendingNode{ MoveTemp(Value), (Index & 1) == 0 });
+							return;
+						}
+					}
+
+					if (Other.IsSet())
+					{
+						--NumRemaining;
+					}
+				}
+
+				if (Other.IsSet())
+				{
+					ScheduleCombine(Level + 1, Index / 2, bOtherIsLeft ? MoveTemp(Other.GetValue()) : MoveTemp(Value), bOtherIsLeft ? MoveTemp(Value) : MoveTemp(Other.GetValue()));
+				}
+				else
+				{
+					Promise.SetValue(MoveTemp(Value));
+				}
+			}
+
+			void OnFailed(TExpected<T>&& Failure)
+			{
+				{
+					FScopeLock Lock(&CriticalSection);
+					if (bFinished)
+					{
+						return;
+					}
+
+					bFinished = true;
+					Pending.Empty();
+					Unordered.Reset();
+				}
+				Promise.SetValue(MoveTemp(Failure));
+			}
+
+		private:
+			struct FPendingNode
+			{
+				T Value;
+				bool bIsLeft;
+			};
+
+			int32 GetLevelSize(const int32 Level) const
+			{
+				return static_cast<int32>((int64(NumFutures) + (int64(1) << Level) - 1) >> Level);
+			}
+
+			static uint64 GetNodeKey(const int32 Level, const int32 Index)
+			{
+				return (uint64(Level) << 32) | uint32(Index);
+			}
+
+			void ScheduleCombine(const int32 Level, const int32 Index, T&& Left, T&& Right)
+			{
+				const auto State = this->AsShared();
+				SD::Async([State, Level, Index, Left = MoveTemp(Left), Right = MoveTemp(Right)]() mutable
+				{
+					State->OnValue(Level, Index, State->Combine(MoveTemp(Left), MoveTemp(Right)));
+				}, Options)
+				.Then([State](const SD::TExpected<void>& Result)
+				{
+					//Only fails if the combine was cancelled before it ran
+					if (!Result.IsCompleted())
+					{
+						State->OnFailed(ConvertIncomplete<T>(Result));
+					}
+				}, FExpectedFutureOptions(EExpectedFutureExecutionPolicy::Inline));
+			}
+
+			const F Combine;
+			const FExpectedFutureOptions Options;
+			const EReduceOrder Order;
+			const int32 NumFutures;
+
+			TExpectedPromise<T> Promise;
+
+			FCriticalSection CriticalSection;
+			int32 NumRemaining;
+			bool bFinished = false;
+			TMap<uint64, FPendingNode> Pending;
+			TOptional<T> Unordered;
+		};
+	}
+
+	/*
+	*	Combines the values of all the futures into one, pairwise as they become available rather than in one final
+	*	continuation, with each combine running on the given execution policy. Combine is called as
+	*	T Combine(T&& Left, T&& Right) and may be called concurrently. Identity is the result for an empty array.
+	*	Fails as soon as any of the futures do.
+	*/
+	template<typename T, typename F>
+	SD::TExpectedFuture<T> ReduceAsync(const TArray<SD::TExpectedFuture<T>>& Futures, T Identity, F&& Combine,
+		const FExpectedFutureOptions& Options = FExpectedFutureOptions(), const EReduceOrder Order = EReduceOrder::Ordered)
+	{
+		if (Futures.Num() == 0)
+		{
+			return MakeReadyFuture<T>(MoveTemp(Identity));
+		}
+
+		using FState = Details::TReduceState<T, std::decay_t<F>>;
+		const auto State = MakeShared<FState, ESPMode::ThreadSafe>(Futures.Num(), std::decay_t<F>(Forward<F>(Combine)), Options, Order);
+
+		for (int32 Index = 0; Index < Futures.Num(); ++Index)
+		{
+			Futures[Index].Then([State, Index](SD::TExpected<T> Result)
+				{
+					if (Result.IsCompleted())
+					{
+						State->OnValue(0, Index, MoveTemp(*Result));
+					}
+					else
+					{
+						State->OnFailed(MoveTemp(Result));
+					}
+				}, FExpectedFutureOptions(EExpectedFutureExecutionPolicy::Inline));
+		}
+		return State->GetFuture();
+	}
+
+	namespace Details
+	{
+		/*
+		*	Starts an operation whenever one finishes, up to MaxInFlight at a time. Completions only queue a start, and
+		*	whichever call found the queue empty runs them in a loop, so operations that complete immediately do not
+		*	recurse once per input.
+		*/
+		template<typename T, typename R, typename F>
+		class TMapConcurrentState : public TWhenAllValuesState<R>, public TSharedFromThis<TMapConcurrentState<T, R, F>, ESPMode::ThreadSafe>
+		{
+		public:
+			TMapConcurrentState(TArray<T>&& InInputs, F&& InFunc, const EFailMode InFailMode, const FExpectedFutureOptions& InOptions)
+				: TWhenAllValuesState<R>(InInputs.Num(), InFailMode)
+				, Inputs(MoveTemp(InInputs))
+				, Func(MoveTemp(InFunc))
+				, Options(InOptions)
+			{}
+
+			void StartNext()
+			{
+				if (NumPendingStarts.fetch_add(1, std::memory_order_acq_rel) != 0)
+				{
+					return;
+				}
+
+				do
+				{
+					if (NextIndex < Inputs.Num() && !this->IsFinished())
+					{
+						Start(NextIndex++);
+					}
+				}
+				while (NumPendingStarts.fetch_sub(1, std::memory_order_acq_rel) != 1);
+			}
+
+		private:
+			void Start(const int32 Index)
+			{
+				const auto State = this->AsShared();
+				StartOperation(Index).Then([State, Index](SD::TExpected<R> Result)
+				{
+					if (Result.IsCompleted())
+					{
+						State->OnSucceeded(Index, MoveTemp(*Result));
+					}
+					else
+					{
+						State->OnFailed(ConvertIncomplete<TArray<R>>(Result));
+					}
+
+					if (State->OnAntecedentDone())
+					{
+						State->Complete([&State]() { return State->TakeValues(); });
+					}
+					else
+					{
+						State->StartNext();
+					}
+				}, FExpectedFutureOptions(EExpectedFutureExecutionPolicy::Inline));
+			}
+
+			TExpectedFuture<R> StartOperation(const int32 Index)
+			{
+				using FuncResultType = decltype(Func(std::declval<const T&>()));
+				if constexpr (FutureExtensionTypeTraits::TIsExpectedFuture<FuncResultType>::value)
+				{
+					//Already asynchronous, so start it straight away on this thread
+					return Func(Inputs[Index]);
+				}
+				else
+				{
+					const auto State = this->AsShared();
+					return SD::Async([State, Index]()
+					{
+						return State->Func(State->Inputs[Index]);
+					}, Options);
+				}
+			}
+
+			const TArray<T> Inputs;
+			F Func;
+			const FExpectedFutureOptions Options;
+
+			//Only read and written by the call that is running the start loop
+			int32 NextIndex = 0;
+			std::atomic<int32> NumPendingStarts{ 0 };
+		};
+	}
+
+	/*
+	*	Calls Func on every element of Inputs with at most MaxInFlight of them outstanding at once, starting the next
+	*	as each one finishes, and completes with the results in the same order. Func is called as either
+	*	SD::TExpectedFuture<R> Func(const T& Input), from the thread that finished the previous operation, or
+	*	R Func(const T& Input), which is run with the given execution policy.
+	*	Failures are reported as for WhenAll. A fast failure, or cancelling the handle in Options, stops any more
+	*	operations from starting.
+	*/
+	template<typename T, typename F>
+	auto MapConcurrent(TArray<T> Inputs, const int32 MaxInFlight, F&& Func, const EFailMode FailMode = EFailMode::Full,
+		const FExpectedFutureOptions& Options = FExpectedFutureOptions())
+	{
+		using FuncResultType = std::decay_t<decltype(Func(std::declval<const T&>()))>;
+		using R = typename FutureExtensionTypeTraits::TUnwrap<FuncResultType>::Type;
+		static_assert(!std::is_void<R>::value, "SD::MapConcurrent - Func must return a value.");
+
+		if (MaxInFlight <= 0)
+		{
+			return MakeErrorFuture<TArray<R>>(Error::Static(Errors::ERROR_INVALID_ARGUMENT, TEXT("SD::MapConcurrent - MaxInFlight must be positive")));
+		}
+		if (Inputs.Num() == 0)
+		{
+			return MakeReadyFuture<TArray<R>>(TArray<R>());
+		}
+
+		using FState = Details::TMapConcurrentState<T, R, std::decay_t<F>>;
+		const int32 NumToStart = FMath::Min(MaxInFlight, Inputs.Num());
+		const auto State = MakeShared<FState, ESPMode::ThreadSafe>(MoveTemp(Inputs), std::decay_t<F>(Forward<F>(Func)), FailMode, Options);
+
+		FutureExtensionTaskGraph::TryAddPromiseToCancellationHandle(Options.GetCancellationTokenHandle(), State->GetCancellablePromise());
+
+		//Hold on to the future first, in case everything completes during these calls
+		TExpectedFuture<TArray<R>> Future = State->GetFuture();
+		for (int32 Index = 0; Index < NumToStart; ++Index)
+		{
+			State->StartNext();
+		}
+		return Future;
 	}
 
 	SDFUTUREEXTENSIONS_API TExpectedFuture<void> WaitAsync(const float DelayInSeconds);
+
+	struct SDFUTUREEXTENSIONS_API FRetryPolicy
+	{
+		//Including the first attempt
+		int32 MaxAttempts = 3;
+
+		//Delay before the first retry, multiplied by BackoffMultiplier for each one after it up to MaxDelaySeconds
+		float InitialDelaySeconds = 0.1f;
+		float BackoffMultiplier = 2.0f;
+		float MaxDelaySeconds = 10.0f;
+
+		//Waits a random time of up to the backoff delay, so callers that failed together do not all retry together
+		bool bFullJitter = true;
+
+		//Decides which errors are worth retrying, typically by error code. Every error is retried if unset.
+		//Cancellations are never retried.
+		TFunction<bool(const SD::Error&)> ShouldRetry;
+
+		//NumFailedAttempts starts at 1 for the delay before the first retry
+		float GetDelaySeconds(const int32 NumFailedAttempts) const;
+	};
+
+	namespace Details
+	{
+		//The promise outlives every attempt, so retrying does not add to a chain of nested futures
+		template<typename T, typename F>
+		class TRetryState : public TSharedFromThis<TRetryState<T, F>, ESPMode::ThreadSafe>
+		{
+		public:
+			TRetryState(F&& InFactory, const FRetryPolicy& InPolicy, const FExpectedFutureOptions& InOptions)
+				: Factory(MoveTemp(InFactory))
+				, Policy(InPolicy)
+				, Options(InOptions)
+			{}
+
+			TExpectedFuture<T> GetFuture()
+			{
+				return Promise.GetFuture();
+			}
+
+			CancellablePromiseRef GetCancellablePromise() const
+			{
+				return Promise.GetCancellablePromise();
+			}
+
+			void StartAttempt()
+			{
+				//Already cancelled
+				if (Promise.IsSet())
+				{
+					return;
+				}
+
+				++NumAttempts;
+				const auto State = this->AsShared();
+				Factory().Then([State](SD::TExpected<T> Result)
+				{
+					State->OnAttemptDone(MoveTemp(Result));
+				}, FExpectedFutureOptions(EExpectedFutureExecutionPolicy::Inline));
+			}
+
+		private:
+			void OnAttemptDone(SD::TExpected<T>&& Result)
+			{
+				if (!ShouldRetry(Result))
+				{
+					Promise.SetValue(MoveTemp(Result));
+					return;
+				}
+
+				//Cancelling the handle in Options skips the next attempt
+				const auto State = this->AsShared();
+				WaitAsync(Policy.GetDelaySeconds(NumAttempts)).Then([State]()
+				{
+					State->StartAttempt();
+				}, Options);
+			}
+
+			bool ShouldRetry(const SD::TExpected<T>& Result) const
+			{
+				return Result.IsError()
+					&& NumAttempts < Policy.MaxAttempts
+					&& !Promise.IsSet()
+					&& (!Policy.ShouldRetry || Policy.ShouldRetry(*Result.GetError()));
+			}
+
+			F Factory;
+			const FRetryPolicy Policy;
+			const FExpectedFutureOptions Options;
+
+			TExpectedPromise<T> Promise;
+
+			//Attempts run one after another, each ordered after the last by its continuation
+			int32 NumAttempts = 0;
+		};
+	}
+
+	/*
+	*	Calls Factory, which returns a TExpectedFuture<T>, until it succeeds or the policy gives up, and completes with
+	*	the result of the last attempt. The first attempt starts straight away on the calling thread, and retries
+	*	start with the execution policy in Options once their delay has passed. Cancelling the handle in Options
+	*	cancels the result and stops any further attempts.
+	*/
+	template<typename F>
+	auto Retry(F&& Factory, const FRetryPolicy& Policy = FRetryPolicy(), const FExpectedFutureOptions& Options = FExpectedFutureOptions())
+	{
+		using FutureType = std::decay_t<decltype(Factory())>;
+		static_assert(FutureExtensionTypeTraits::TIsExpectedFuture<FutureType>::value, "SD::Retry - Factory must return a TExpectedFuture.");
+		using T = typename FutureType::ResultType;
+
+		using FState = Details::TRetryState<T, std::decay_t<F>>;
+		const auto State = MakeShared<FState, ESPMode::ThreadSafe>(std::decay_t<F>(Forward<F>(Factory)), Policy, Options);
+
+		FutureExtensionTaskGraph::TryAddPromiseToCancellationHandle(Options.GetCancellationTokenHandle(), State->GetCancellablePromise());
+
+		TExpectedFuture<T> Future = State->GetFuture();
+		State->StartAttempt();
+		return Future;
+	}
+
+	namespace Details
+	{
+		//Whichever of the future and the timer finishes first sets the result. The other one is ignored.
+		template<typename T>
+		class TWithTimeoutState
+		{
+		public:
+			explicit TWithTimeoutState(const SharedCancellationHandlePtr& InCancellationHandle)
+				: CancellationHandle(InCancellationHandle)
+			{}
+
+			TExpectedFuture<T> GetFuture()
+			{
+				return Promise.GetFuture();
+			}
+
+			void OnCompleted(SD::TExpected<T>&& Result)
+			{
+				FTSTicker::RemoveTicker(TickerHandle);
+				if (TryFinish())
+				{
+					Promise.SetValue(MoveTemp(Result));
+				}
+			}
+
+			void OnTimedOut()
+			{
+				if (TryFinish())
+				{
+					Promise.SetValue(Error::Static(Errors::ERROR_TIMED_OUT, TEXT("SD::WithTimeout - Timed out")));
+					if (CancellationHandle.IsValid())
+					{
+						CancellationHandle->Cancel();
+					}
+				}
+			}
+
+			//Written before the future's continuation is added, which orders it before OnCompleted reads it
+			FTSTicker::FDelegateHandle TickerHandle;
+
+		private:
+			bool TryFinish()
+			{
+				bool bAlreadyFinished = false;
+				return bFinished.compare_exchange_strong(bAlreadyFinished, true, std::memory_order_relaxed);
+			}
+
+			TExpectedPromise<T> Promise;
+			const SharedCancellationHandlePtr CancellationHandle;
+			std::atomic<bool> bFinished{ false };
+		};
+
+		template<typename T>
+		SD::TExpectedFuture<T> WithTimeout(const SD::TExpectedFuture<T>& Future, const float TimeoutSeconds, const SharedCancellationHandlePtr& CancellationHandle)
+		{
+			if (Future.IsReady())
+			{
+				return Future;
+			}
+
+			const auto State = MakeShared<TWithTimeoutState<T>, ESPMode::ThreadSafe>(CancellationHandle);
+
+			//Runs on the core ticker, so the timeout is only as precise as the game thread's frame time
+			State->TickerHandle = FTSTicker::GetCoreTicker().AddTicker(FTickerDelegate::CreateLambda([State](const float Delta)
+			{
+				State->OnTimedOut();
+
+				// false = don't need to execute again
+				return false;
+			}), TimeoutSeconds);
+
+			Future.Then([State](SD::TExpected<T> Result)
+			{
+				State->OnCompleted(MoveTemp(Result));
+			}, FExpectedFutureOptions(EExpectedFutureExecutionPolicy::Inline));
+
+			return State->GetFuture();
+		}
+	}
+
+	/*
+	*	Completes with the result of Future, or with an Errors::ERROR_TIMED_OUT error if that takes longer than
+	*	TimeoutSeconds, in which case CancellationHandle is cancelled to stop the work behind Future. The timer is
+	*	removed as soon as Future completes.
+	*/
+	template<typename T>
+	SD::TExpectedFuture<T> WithTimeout(const SD::TExpectedFuture<T>& Future, const float TimeoutSeconds, const SharedCancellationHandleRef& CancellationHandle)
+	{
+		return Details::WithTimeout(Future, TimeoutSeconds, SharedCancellationHandlePtr(CancellationHandle));
+	}
+
+	//Times out without cancelling anything, for work that cannot be stopped or is left to finish in the background
+	template<typename T>
+	SD::TExpectedFuture<T> WithTimeout(const SD::TExpectedFuture<T>& Future, const float TimeoutSeconds)
+	{
+		return Details::WithTimeout(Future, TimeoutSeconds, SharedCancellationHandlePtr());
+	}
+
+	struct FHedgeStats
+	{
+		//Calls to Hedge
+		int64 NumRequests = 0;
+
+		//Duplicate requests started because the ones before them had not completed within the hedge delay
+		int64 NumHedgesStarted = 0;
+
+		//Requests whose result came from a duplicate rather than the original
+		int64 NumHedgesWon = 0;
+	};
+
+	//Totals for every call to Hedge so far, for tuning the hedge delay against the latency of the requests
+	SDFUTUREEXTENSIONS_API FHedgeStats GetHedgeStats();
+
+	namespace Details
+	{
+		struct SDFUTUREEXTENSIONS_API FHedgeCounters
+		{
+			static void OnRequest();
+			static void OnHedgeStarted();
+			static void OnHedgeWon();
+		};
+
+		/*
+		*	Each attempt gets its own cancellation handle, so the ones that lose can be cancelled once the first
+		*	succeeds. The timer for the next duplicate is removed at the same time. An attempt that fails is only the
+		*	result once no other attempt is left that could still succeed.
+		*/
+		template<typename T, typename F>
+		class THedgeState : public TSharedFromThis<THedgeState<T, F>, ESPMode::ThreadSafe>
+		{
+		public:
+			THedgeState(F&& InFactory, const float InHedgeDelaySeconds, const int32 InMaxHedges)
+				: Factory(MoveTemp(InFactory))
+				, HedgeDelaySeconds(InHedgeDelaySeconds)
+				, MaxHedges(InMaxHedges)
+			{}
+
+			TExpectedFuture<T> GetFuture()
+			{
+				return Promise.GetFuture();
+			}
+
+			void StartAttempt(const int32 Index)
+			{
+				const SharedCancellationHandleRef CancellationHandle = CreateCancellationHandle();
+				{
+					FScopeLock Lock(&CriticalSection);
+					bHedgePending = false;
+					if (bFinished)
+					{
+						return;
+					}
+
+					CancellationHandles.Add(CancellationHandle);
+					if (Index < MaxHedges)
+					{
+						bHedgePending = true;
+						const auto State = this->AsShared();
+						NextHedgeTicker = FTSTicker::GetCoreTicker().AddTicker(FTickerDelegate::CreateLambda([State, Index](const float Delta)
+						{
+							State->StartAttempt(Index + 1);
+
+							// false = don't need to execute again
+							return false;
+						}), HedgeDelaySeconds);
+					}
+				}
+
+				if (Index > 0)
+				{
+					FHedgeCounters::OnHedgeStarted();
+				}
+
+				const auto State = this->AsShared();
+				Factory(CancellationHandle).Then([State, Index](SD::TExpected<T> Result)
+				{
+					State->OnAttemptDone(Index, MoveTemp(Result));
+				}, FExpectedFutureOptions(EExpectedFutureExecutionPolicy::Inline));
+			}
+
+		private:
+			void OnAttemptDone(const int32 Index, SD::TExpected<T>&& Result)
+			{
+				TArray<SharedCancellationHandleRef> Losers;
+				FTSTicker::FDelegateHandle Ticker;
+				{
+					FScopeLock Lock(&CriticalSection);
+					if (bFinished)
+					{
+						return;
+					}
+
+					if (Result.IsError())
+					{
+						//Keep waiting on the attempts still running, or the duplicate still to come
+						++NumFailed;
+						if (!FirstError.IsSet())
+						{
+							FirstError = MoveTemp(Result);
+						}
+						if (NumFailed < CancellationHandles.Num() || bHedgePending)
+						{
+							return;
+						}
+						Result = MoveTemp(FirstError.GetValue());
+					}
+
+					bFinished = true;
+					Losers = MoveTemp(CancellationHandles);
+					Losers.RemoveAt(Index);
+					Ticker = MoveTemp(NextHedgeTicker);
+				}
+
+				FTSTicker::RemoveTicker(Ticker);
+				if (Index > 0 && Result.IsCompleted())
+				{
+					FHedgeCounters::OnHedgeWon();
+				}
+
+				Promise.SetValue(MoveTemp(Result));
+				for (const SharedCancellationHandleRef& CancellationHandle : Losers)
+				{
+					CancellationHandle->Cancel();
+				}
+			}
+
+			F Factory;
+			const float HedgeDelaySeconds;
+			const int32 MaxHedges;
+
+			TExpectedPromise<T> Promise;
+
+			FCriticalSection CriticalSection;
+			bool bFinished = false;
+			TArray<SharedCancellationHandleRef> CancellationHandles;
+			FTSTicker::FDelegateHandle NextHedgeTicker;
+			bool bHedgePending = false;
+			int32 NumFailed = 0;
+			TOptional<SD::TExpected<T>> FirstError;
+		};
+	}
+
+	/*
+	*	Starts a request and, each time HedgeDelaySeconds pass without any result, a duplicate of it, up to MaxHedges
+	*	duplicates. Completes with whichever succeeds first and cancels the rest, so only use it for idempotent requests.
+	*	Failed attempts do not stop the others; if every attempt fails, the result is the first error.
+	*	Factory is called as SD::TExpectedFuture<T> Factory(const SD::SharedCancellationHandleRef& CancellationHandle),
+	*	and should pass the handle on to the work it starts. Duplicates are started from the core ticker.
+	*/
+	template<typename F>
+	auto Hedge(F&& Factory, const float HedgeDelaySeconds, const int32 MaxHedges)
+	{
+		using FutureType = std::decay_t<decltype(Factory(CreateCancellationHandle()))>;
+		static_assert(FutureExtensionTypeTraits::TIsExpectedFuture<FutureType>::value, "SD::Hedge - Factory must return a TExpectedFuture.");
+		using T = typename FutureType::ResultType;
+
+		if (MaxHedges < 0)
+		{
+			return MakeErrorFuture<T>(Error::Static(Errors::ERROR_INVALID_ARGUMENT, TEXT("SD::Hedge - MaxHedges must not be negative")));
+		}
+
+		Details::FHedgeCounters::OnRequest();
+
+		using FState = Details::THedgeState<T, std::decay_t<F>>;
+		const auto State = MakeShared<FState, ESPMode::ThreadSafe>(std::decay_t<F>(Forward<F>(Factory)), HedgeDelaySeconds, MaxHedges);
+
+		TExpectedFuture<T> Future = State->GetFuture();
+		State->StartAttempt(0);
+		return Future;
+	}
 }
@@ -0,0 +1,104 @@
+// Copyright(c) Splash Damage. All rights reserved.
+#pragma once
+
+#include "ExpectedFuture.h"
+#include "FutureExtensionsTypeTraits.h"
+#include "Containers/Map.h"
+#include "HAL/CriticalSection.h"
+#include "Misc/ScopeLock.h"
+
+#include <type_traits>
+
+namespace SD
+{
+	/*
+	*	Coalesces concurrent requests for the same key: while a request is in flight, every caller asking for its key
+	*	gets the same future rather than starting another one. The entry is dropped as soon as the request completes,
+	*	so results (including errors) are never cached, and the next caller starts a new request.
+	*
+	*	Keys are split between NumShards separately locked maps, so callers asking for different keys rarely contend.
+	*	Requests that are still in flight keep the maps alive if the TSingleFlight is destroyed first.
+	*/
+	template<typename KeyType, typename T, int32 NumShards = 16>
+	class TSingleFlight
+	{
+		static_assert(NumShards > 0, "SD::TSingleFlight - Must have at least one shard.");
+
+	public:
+		TSingleFlight()
+			: Shards(MakeShared<FShards, ESPMode::ThreadSafe>())
+		{}
+
+		TSingleFlight(const TSingleFlight&) = delete;
+		TSingleFlight& operator=(const TSingleFlight&) = delete;
+
+		/*
+		*	Returns the future for the request in flight for Key, or calls Factory to start one. Factory is called as
+		*	SD::TExpectedFuture<T> Factory(), on the calling thread and outside of any lock.
+		*/
+		template<typename F>
+		TExpectedFuture<T> Get(const KeyType& Key, F&& Factory)
+		{
+			using FutureType = std::decay_t<decltype(Factory())>;
+			static_assert(std::is_same<FutureType, TExpectedFuture<T>>::value, "SD::TSingleFlight - Factory must return a TExpectedFuture<T>.");
+
+			FShard& Shard = Shards->GetShard(Key);
+
+			//Registered before the request starts, so it is already in the map if the request completes straight away
+			TExpectedPromise<T> Promise;
+			TExpectedFuture<T> Future = Promise.GetFuture();
+			{
+				FScopeLock Lock(&Shard.CriticalSection);
+				if (const TExpectedFuture<T>* InFlight = Shard.InFlight.Find(Key))
+				{
+					return *InFlight;
+				}
+				Shard.InFlight.Add(Key, Future);
+			}
+
+			Factory().Then([Shards = Shards, Key, Promise](TExpected<T> Result) mutable
+			{
+				//Dropped before the value is set, so callers that see the result never get this request back
+				FShard& Shard = Shards->GetShard(Key);
+				{
+					FScopeLock Lock(&Shard.CriticalSection);
+					Shard.InFlight.Remove(Key);
+				}
+				Promise.SetValue(MoveTemp(Result));
+			}, FExpectedFutureOptions(EExpectedFutureExecutionPolicy::Inline));
+
+			return Future;
+		}
+
+		int32 GetNumInFlight() const
+		{
+			int32 NumInFlight = 0;
+			for (FShard& Shard : Shards->Shards)
+			{
+				FScopeLock Lock(&Shard.CriticalSection);
+				NumInFlight += Shard.InFlight.Num();
+			}
+			return NumInFlight;
+		}
+
+	private:
+		//Each shard on its own cache line, so locking one does not slow down threads using its neighbours
+		struct alignas(PLATFORM_CACHE_LINE_SIZE) FShard
+		{
+			FCriticalSection CriticalSection;
+			TMap<KeyType, TExpectedFuture<T>> InFlight;
+		};
+
+		struct FShards
+		{
+			FShard& GetShard(const KeyType& Key)
+			{
+				return Shards[GetTypeHash(Key) % NumShards];
+			}
+
+			FShard Shards[NumShards];
+		};
+
+		TSharedRef<FShards, ESPMode::ThreadSafe> Shards;
+	};
+}
@@ -0,0 +1,123 @@
+// Copyright(c) Splash Damage. All rights reserved.
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Templates/RefCounting.h"
+
+namespace SD
+{
+	namespace Details
+	{
+		template<typename WaiterType>
+		class TWaiterQueue;
+
+		//The links a waiter needs to be in a TWaiterQueue. Only touched by the queue, under the lock that guards it.
+		template<typename WaiterType>
+		class TWaiterQueueLink
+		{
+			friend class TWaiterQueue<WaiterType>;
+
+		private:
+			WaiterType* PrevWaiter = nullptr;
+			WaiterType* NextWaiter = nullptr;
+			bool bQueued = false;
+		};
+
+		/*
+		*	Intrusive FIFO of waiters, so both taking the front one and taking out one that was cancelled are O(1).
+		*	Holds a reference to each waiter in it. Not thread safe: whoever owns it keeps it behind a lock.
+		*/
+		template<typename WaiterType>
+		class TWaiterQueue
+		{
+			using FLink = TWaiterQueueLink<WaiterType>;
+
+		public:
+			TWaiterQueue() = default;
+
+			~TWaiterQueue()
+			{
+				while (!IsEmpty())
+				{
+					PopFront();
+				}
+			}
+
+			TWaiterQueue(const TWaiterQueue&) = delete;
+			TWaiterQueue& operator=(const TWaiterQueue&) = delete;
+
+			bool IsEmpty() const
+			{
+				return Head == nullptr;
+			}
+
+			WaiterType& Front() const
+			{
+				check(!IsEmpty());
+				return *Head;
+			}
+
+			void PushBack(WaiterType& Waiter)
+			{
+				FLink& Link = Waiter;
+				check(!Link.bQueued);
+				Waiter.AddRef();
+				Link.bQueued = true;
+				Link.PrevWaiter = Tail;
+				Link.NextWaiter = nullptr;
+				if (Tail != nullptr)
+				{
+					static_cast<FLink&>(*Tail).NextWaiter = &Waiter;
+				}
+				else
+				{
+					Head = &Waiter;
+				}
+				Tail = &Waiter;
+			}
+
+			TRefCountPtr<WaiterType> PopFront()
+			{
+				return Unlink(Front());
+			}
+
+			//Returns null if the waiter has already left the queue
+			TRefCountPtr<WaiterType> Remove(WaiterType& Waiter)
+			{
+				return static_cast<FLink&>(Waiter).bQueued ? Unlink(Waiter) : TRefCountPtr<WaiterType>();
+			}
+
+		private:
+			//Hands the queue's reference over to the caller
+			TRefCountPtr<WaiterType> Unlink(WaiterType& Waiter)
+			{
+				FLink& Link = Waiter;
+				if (Link.PrevWaiter != nullptr)
+				{
+					static_cast<FLink&>(*Link.PrevWaiter).NextWaiter = Link.NextWaiter;
+				}
+				else
+				{
+					Head = Link.NextWaiter;
+				}
+
+				if (Link.NextWaiter != nullptr)
+				{
+					static_cast<FLink&>(*Link.NextWaiter).PrevWaiter = Link.PrevWaiter;
+				}
+				else
+				{
+					Tail = Link.PrevWaiter;
+				}
+
+				Link.PrevWaiter = nullptr;
+				Link.NextWaiter = nullptr;
+				Link.bQueued = false;
+				return TRefCountPtr<WaiterType>(&Waiter, false);
+			}
+
+			WaiterType* Head = nullptr;
+			WaiterType* Tail = nullptr;
+		};
+	}
+}
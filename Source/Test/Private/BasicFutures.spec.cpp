@@ -12,6 +12,33 @@
 /* FUTURE BASIC SPEC                                                    */
 /************************************************************************/
 
+//Counts how many times values are copied as they are passed along a chain
+struct FCopyCounter
+{
+	static int32 NumCopies;
+
+	FCopyCounter() = default;
+	FCopyCounter(FCopyCounter&&) = default;
+	FCopyCounter& operator=(FCopyCounter&&) = default;
+
+	FCopyCounter(const FCopyCounter& Other)
+		: Payload(Other.Payload)
+	{
+		++NumCopies;
+	}
+
+	FCopyCounter& operator=(const FCopyCounter& Other)
+	{
+		Payload = Other.Payload;
+		++NumCopies;
+		return *this;
+	}
+
+	TArray<int32> Payload;
+};
+
+int32 FCopyCounter::NumCopies = 0;
+
 class FFutureTestSpec_Basic : public FFutureTestSpec
 {
 	GENERATE_SPEC(FFutureTestSpec_Basic, "FutureExtensions.Basic",
@@ -320,6 +347,44 @@ void FFutureTestSpec_Basic::Define()
 		});
 	});
 
+	Describe("Expected", [this]()
+	{
+		static_assert(!std::is_polymorphic<SD::TExpected<int32>>::value, "TExpected should not need a vtable");
+		static_assert(!std::is_polymorphic<SD::TExpected<void>>::value, "TExpected should not need a vtable");
+
+		LatentIt("Copies share the same error", [this](const auto& Done)
+		{
+			const SD::TExpected<FString> Expected = SD::MakeErrorExpected<FString>(SD::Error(ErrorCode, ErrorContext));
+			const SD::TExpected<FString> Copy = Expected;
+
+			TestTrue("Copy is an error", Copy.IsError());
+			TestEqual("Error Code", Copy.GetError()->GetErrorCode(), ErrorCode);
+			TestTrue("Error is shared", &Expected.GetError().Get() == &Copy.GetError().Get());
+			Done.Execute();
+		});
+
+		LatentIt("Can be reassigned between value and error states", [this](const auto& Done)
+		{
+			SD::TExpected<FString> Expected = SD::MakeReadyExpected(FString(TEXT("Value")));
+			TestEqual("Value", *Expected, TEXT("Value"));
+
+			Expected = SD::Error(ErrorCode, ErrorContext, TEXT("Bad times!"));
+			TestTrue("Is an error", Expected.IsError());
+			TestEqual("Error Message", *Expected.GetError()->GetErrorInfo(), TEXT("Bad times!"));
+
+			Expected = *Expected.GetError();
+			TestEqual("Error Code after self assignment", Expected.GetError()->GetErrorCode(), ErrorCode);
+
+			Expected = FString(TEXT("Other Value"));
+			TestTrue("Is completed", Expected.IsCompleted());
+			TestEqual("Value", *Expected, TEXT("Other Value"));
+
+			SD::TExpected<FString> Moved = MoveTemp(Expected);
+			TestEqual("Moved Value", *Moved, TEXT("Other Value"));
+			Done.Execute();
+		});
+	});
+
 	Describe("Errors", [this]()
 	{
 		LatentIt("Can return an error and be received in expected then", [this](const auto& Done)
@@ -403,7 +468,210 @@ void FFutureTestSpec_Basic::Define()
 				Done.Execute();
 			});
 		});
+
+		LatentIt("Can take error info from literals, names and strings", [this](const auto& Done)
+		{
+			const SD::Error LiteralError = SD::Error::Static(ErrorCode, ErrorContext, TEXT("Bad times!"));
+			const SD::Error NameError(ErrorCode, FName(TEXT("BadTimes")));
+			const SD::Error StringError(ErrorCode, FString::Printf(TEXT("Bad times x%d!"), 2));
+			const SD::Error NoInfoError(ErrorCode);
+
+			TestEqual("Literal Error Context", LiteralError.GetErrorContext(), ErrorContext);
+			TestEqual("Literal Error Message", *LiteralError.GetErrorInfo(), TEXT("Bad times!"));
+			TestEqual("Name Error Message", *NameError.GetErrorInfo(), TEXT("BadTimes"));
+			TestEqual("String Error Message", StringError.GetErrorInfoString(), TEXT("Bad times x2!"));
+			TestTrue("String Error Info is shared", StringError.GetErrorInfo() == StringError.GetErrorInfo());
+			TestFalse("No Error Info", NoInfoError.HasErrorInfo() || NoInfoError.GetErrorInfo().IsValid());
+			Done.Execute();
+		});
+
+		LatentIt("Copies error info from a TCHAR array that is not a literal", [this](const auto& Done)
+		{
+			TCHAR Buffer[16];
+			FCString::Strcpy(Buffer, TEXT("Bad times!"));
+			const SD::Error BufferError(ErrorCode, Buffer);
+
+			FCString::Strcpy(Buffer, TEXT("Overwritten"));
+			TestEqual("Error Message", BufferError.GetErrorInfoString(), TEXT("Bad times!"));
+			Done.Execute();
+		});
+
+		LatentIt("Only formats lazy error info once it is read", [this](const auto& Done)
+		{
+			int32 NumFormatted = 0;
+			SD::TExpected<int32> Expected = SD::MakeErrorExpected<int32>(SD::Error::Lazy(ErrorCode, [&NumFormatted]()
+			{
+				++NumFormatted;
+				return FString(TEXT("Bad times!"));
+			}));
+
+			const SD::TExpected<FString> Converted = SD::Convert<FString>(Expected);
+			TestEqual("Formatted before reading", NumFormatted, 0);
+
+			TestEqual("Error Message", *Converted.GetError()->GetErrorInfo(), TEXT("Bad times!"));
+			TestEqual("Error Message", Expected.GetError()->GetErrorInfoString(), TEXT("Bad times!"));
+			TestEqual("Formatted after reading", NumFormatted, 1);
+			Done.Execute();
+		});
+
+		LatentIt("Shares the error when converting between result types", [this](const auto& Done)
+		{
+			const SD::TExpected<int32> Expected = SD::MakeErrorExpected<int32>(SD::Error(ErrorCode, ErrorContext));
+			const SD::TExpected<FString> Converted = SD::Convert<FString>(Expected);
+			const SD::TExpected<void> ConvertedVoid = SD::ConvertIncomplete<void>(Converted);
+
+			TestTrue("Error is shared", &Expected.GetError().Get() == &Converted.GetError().Get());
+			TestTrue("Error is shared", &Expected.GetError().Get() == &ConvertedVoid.GetError().Get());
+			Done.Execute();
+		});
+	});
+
+	LatentIt("Promise, futures and cancellation share a single allocation", [this](const auto& Done)
+	{
+		SD::SharedCancellationHandleRef CancellationHandle = SD::CreateCancellationHandle();
+		const uint64 NumAllocationsBefore = SD::FutureAllocator::GetNumAllocationsOnCurrentThread();
+
+		{
+			SD::TExpectedPromise<int32> Promise;
+			SD::TExpectedFuture<int32> Future = Promise.GetFuture();
+			SD::TExpectedFuture<int32> SecondFuture = Promise.GetFuture();
+			SD::TExpectedFuture<int32> FutureCopy = Future;
+			CancellationHandle->AddPromise(Promise.GetCancellablePromise());
+
+			Promise.SetValue(5);
+			TestEqual("Value", *FutureCopy.Get(), 5);
+			TestTrue("Second future is ready", SecondFuture.IsReady());
+		}
+
+		TestEqual("Number of allocations", SD::FutureAllocator::GetNumAllocationsOnCurrentThread() - NumAllocationsBefore, uint64(1));
+		Done.Execute();
+	});
+
+	LatentIt("Cancellation handle does not keep a completed promise alive", [this](const auto& Done)
+	{
+		SD::SharedCancellationHandleRef CancellationHandle = SD::CreateCancellationHandle();
+		TWeakPtr<int32, ESPMode::ThreadSafe> WeakValue;
+
+		{
+			SD::TExpectedPromise<TSharedPtr<int32, ESPMode::ThreadSafe>> Promise;
+			SD::TExpectedFuture<TSharedPtr<int32, ESPMode::ThreadSafe>> Future = Promise.GetFuture();
+			CancellationHandle->AddPromise(Promise.GetCancellablePromise());
+
+			TSharedPtr<int32, ESPMode::ThreadSafe> Value = MakeShared<int32, ESPMode::ThreadSafe>(5);
+			WeakValue = Value;
+			Promise.SetValue(MoveTemp(Value));
+			TestTrue("Value is held by the promise", WeakValue.IsValid());
+		}
+
+		TestFalse("Value is released with the promise while the handle is still alive", WeakValue.IsValid());
+		Done.Execute();
+	});
+
+	Describe("Value passing", [this]()
+	{
+		const SD::FExpectedFutureOptions InlineOptions(SD::EExpectedFutureExecutionPolicy::Inline);
+
+		LatentIt("Moves the value along a chain with a single consumer per link", [this, InlineOptions](const auto& Done)
+		{
+			FCopyCounter::NumCopies = 0;
+
+			SD::TExpectedPromise<FCopyCounter> Promise;
+			SD::TExpectedFuture<FCopyCounter> Future = Promise.GetFuture()
+				.Then([](FCopyCounter Value)
+				{
+					Value.Payload.Add(1);
+					return Value;
+				}, InlineOptions)
+				.Then([](SD::TExpected<FCopyCounter> Expected)
+				{
+					(*Expected).Payload.Add(2);
+					return Expected;
+				}, InlineOptions)
+				.Then([](FCopyCounter& Value)
+				{
+					Value.Payload.Add(3);
+					return MoveTemp(Value);
+				}, InlineOptions);
+
+			//Otherwise the promise could still hand out a future that reads the value after the first link
+			Promise.SetWriteOnly();
+
+			FCopyCounter Initial;
+			Initial.Payload.Add(0);
+			Promise.SetValue(MoveTemp(Initial));
+
+			TestTrue("Future is ready", Future.IsReady());
+			TestEqual("Number of copies", FCopyCounter::NumCopies, 0);
+			TestEqual("Payload", (*Future.Get()).Payload.Num(), 4);
+			Done.Execute();
+		});
+
+		LatentIt("Copies the value when other futures can still read it", [this, InlineOptions](const auto& Done)
+		{
+			FCopyCounter::NumCopies = 0;
+
+			SD::TExpectedPromise<FCopyCounter> Promise;
+			SD::TExpectedFuture<FCopyCounter> Future = Promise.GetFuture();
+
+			int32 ConstRefPayload = 0;
+			Future.Then([&ConstRefPayload](const FCopyCounter& Value)
+			{
+				ConstRefPayload = Value.Payload.Num();
+			}, InlineOptions);
+
+			int32 ByValuePayload = 0;
+			Future.Then([&ByValuePayload](FCopyCounter Value)
+			{
+				ByValuePayload = Value.Payload.Num();
+			}, InlineOptions);
+
+			FCopyCounter Initial;
+			Initial.Payload.Add(0);
+			Promise.SetValue(MoveTemp(Initial));
+
+			TestEqual("Const reference continuation payload", ConstRefPayload, 1);
+			TestEqual("By value continuation payload", ByValuePayload, 1);
+			TestEqual("Number of copies", FCopyCounter::NumCopies, 1);
+			TestEqual("Value is still readable", Future.Get().GetValue()->Payload.Num(), 1);
+			Done.Execute();
+		});
+
+		LatentIt("Copies the value while the promise can still hand out futures", [this, InlineOptions](const auto& Done)
+		{
+			SD::TExpectedPromise<TArray<int32>> Promise;
+
+			int32 ContinuationPayload = 0;
+			Promise.GetFuture().Then([&ContinuationPayload](TArray<int32> Value)
+			{
+				ContinuationPayload = Value.Num();
+			}, InlineOptions);
+
+			Promise.SetValue(TArray<int32>{ 1, 2, 3 });
+
+			TestEqual("Continuation payload", ContinuationPayload, 3);
+			TestEqual("Future taken afterwards still reads the value", (*Promise.GetFuture().Get()).Num(), 3);
+			Done.Execute();
+		});
+	});
+
+#if SDFUTUREEXTENSIONS_ALLOCATOR_STATS
+	LatentIt("Future allocator stats track the promises in use", [this](const auto& Done)
+	{
+		static constexpr int32 NumPromises = 64;
+		const int64 BytesInUseBefore = SD::FutureAllocator::GetStats().BytesInUse;
+
+		TArray<SD::TExpectedPromise<int32>> Promises;
+		Promises.SetNum(NumPromises);
+
+		const SD::FutureAllocator::FStats Stats = SD::FutureAllocator::GetStats();
+		TestTrue("Bytes in use", Stats.BytesInUse - BytesInUseBefore >= int64(NumPromises * sizeof(SD::TExpectedPromiseState<int32>)));
+		for (const SD::FutureAllocator::FPoolStats& Pool : Stats.Pools)
+		{
+			TestTrue("High-water mark", Pool.HighWaterMark >= Pool.NumBlocksInUse);
+		}
+		Done.Execute();
 	});
+#endif
 }
 
 #endif //WITH_DEV_AUTOMATION_TESTS
@@ -0,0 +1,310 @@
+// Copyright 2020 Splash Damage, Ltd. - All Rights Reserved.
+
+#include <CoreMinimal.h>
+#include <FutureExtensions.h>
+
+#include "Helpers/TestHelpers.h"
+
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+/************************************************************************/
+/* FUTURE CACHING SPEC                                                  */
+/************************************************************************/
+
+class FFutureTestSpec_Caching : public FFutureTestSpec
+{
+	GENERATE_SPEC(FFutureTestSpec_Caching, "FutureExtensions.Caching",
+		EAutomationTestFlags::ProductFilter |
+		EAutomationTestFlags::EditorContext |
+		EAutomationTestFlags::ServerContext
+	);
+
+	FFutureTestSpec_Caching() : FFutureTestSpec()
+	{
+		DefaultTimeout = FTimespan::FromSeconds(0.2);
+	}
+
+	static constexpr int32 ErrorCode = 0xdeadbeef;
+};
+
+
+void FFutureTestSpec_Caching::Define()
+{
+	Describe("SingleFlight", [this]()
+	{
+		LatentIt("Shares the request in flight for a key", [this](const auto& Done)
+		{
+			SD::TSingleFlight<FString, int32> SingleFlight;
+			SD::TExpectedPromise<int32> Promise;
+			int32 NumRequests = 0;
+
+			const auto Factory = [&NumRequests, &Promise]()
+			{
+				++NumRequests;
+				return Promise.GetFuture();
+			};
+
+			SD::TExpectedFuture<int32> First = SingleFlight.Get(TEXT("Profile"), Factory);
+			SD::TExpectedFuture<int32> Second = SingleFlight.Get(TEXT("Profile"), Factory);
+
+			TestEqual("Num Requests", NumRequests, 1);
+			TestEqual("Num In Flight", SingleFlight.GetNumInFlight(), 1);
+
+			Promise.SetValue(3);
+
+			TestEqual("Num In Flight once complete", SingleFlight.GetNumInFlight(), 0);
+			TestTrue("First is ready", First.IsReady() && *First.Get() == 3);
+			TestTrue("Second is ready", Second.IsReady() && *Second.Get() == 3);
+			Done.Execute();
+		});
+
+		LatentIt("Starts separate requests for different keys", [this](const auto& Done)
+		{
+			SD::TSingleFlight<int32, int32> SingleFlight;
+			SD::TExpectedPromise<int32> Promise;
+			int32 NumRequests = 0;
+
+			for (int32 Key = 0; Key < 4; ++Key)
+			{
+				SingleFlight.Get(Key, [&NumRequests, &Promise]()
+				{
+					++NumRequests;
+					return Promise.GetFuture();
+				});
+			}
+
+			TestEqual("Num Requests", NumRequests, 4);
+			TestEqual("Num In Flight", SingleFlight.GetNumInFlight(), 4);
+
+			Promise.SetValue(1);
+			TestEqual("Num In Flight once complete", SingleFlight.GetNumInFlight(), 0);
+			Done.Execute();
+		});
+
+		LatentIt("Does not cache errors", [this](const auto& Done)
+		{
+			SD::TSingleFlight<FString, int32> SingleFlight;
+			int32 NumRequests = 0;
+
+			const auto Factory = [&NumRequests]()
+			{
+				++NumRequests;
+				return SD::MakeErrorFuture<int32>(SD::Error(ErrorCode));
+			};
+
+			SD::TExpectedFuture<int32> First = SingleFlight.Get(TEXT("Entitlements"), Factory);
+			SD::TExpectedFuture<int32> Second = SingleFlight.Get(TEXT("Entitlements"), Factory);
+
+			TestTrue("First is an error", First.IsReady() && First.Get().IsError());
+			TestTrue("Second is an error", Second.IsReady() && Second.Get().IsError());
+			TestEqual("Num Requests", NumRequests, 2);
+			Done.Execute();
+		});
+
+		LatentIt("Coalesces requests from many threads", FTimespan::FromSeconds(10.0), [this](const auto& Done)
+		{
+			constexpr int32 NumCallers = 256;
+
+			const auto SingleFlight = MakeShared<SD::TSingleFlight<int32, int32>, ESPMode::ThreadSafe>();
+			const auto NumRequests = MakeShared<std::atomic<int32>, ESPMode::ThreadSafe>(0);
+			const auto NumCalled = MakeShared<std::atomic<int32>, ESPMode::ThreadSafe>(0);
+			SD::TExpectedPromise<int32> Promise;
+
+			TArray<SD::TExpectedFuture<int32>> Callers;
+			for (int32 Index = 0; Index < NumCallers; ++Index)
+			{
+				Callers.Add(SD::Async([SingleFlight, NumRequests, NumCalled, Promise]() mutable
+				{
+					SD::TExpectedFuture<int32> Future = SingleFlight->Get(42, [NumRequests, &Promise]()
+					{
+						NumRequests->fetch_add(1);
+						return Promise.GetFuture();
+					});
+					NumCalled->fetch_add(1);
+					return Future;
+				}, SD::FExpectedFutureOptions(SD::EExpectedFutureExecutionPolicy::ThreadPool)));
+			}
+
+			//Every caller has to have asked for the key before the shared request completes
+			while (NumCalled->load() < NumCallers)
+			{
+				FPlatformProcess::Sleep(0.0f);
+			}
+			Promise.SetValue(7);
+
+			SD::WhenAll(Callers).Then([this, Done, NumRequests](const TArray<int32>& Results)
+			{
+				bool bShared = true;
+				for (const int32 Result : Results)
+				{
+					bShared &= Result == 7;
+				}
+
+				TestTrue("Every caller gets the shared result", bShared);
+				TestEqual("Num Requests", NumRequests->load(), 1);
+				Done.Execute();
+			});
+		});
+	});
+
+	Describe("ExpectedFutureCache", [this]()
+	{
+		LatentIt("Caches values until they expire", [this](const auto& Done)
+		{
+			SD::TExpectedFutureCache<FString, int32>::FSettings Settings;
+			Settings.TimeToLiveSeconds = 0.02f;
+			SD::TExpectedFutureCache<FString, int32> Cache(Settings);
+			int32 NumRequests = 0;
+
+			const auto Factory = [&NumRequests]()
+			{
+				return SD::MakeReadyFuture<int32>(++NumRequests);
+			};
+
+			TestEqual("First", *Cache.Get(TEXT("Key"), Factory).Get(), 1);
+
+			SD::TExpectedFuture<int32> Hit = Cache.Get(TEXT("Key"), Factory);
+			TestTrue("Hit is ready", Hit.IsReady());
+			TestEqual("Hit", *Hit.Get(), 1);
+
+			FPlatformProcess::Sleep(0.04f);
+			TestEqual("Expired", *Cache.Get(TEXT("Key"), Factory).Get(), 2);
+
+			const SD::FExpectedFutureCacheStats Stats = Cache.GetStats();
+			TestEqual("Num Hits", Stats.NumHits, int64(1));
+			TestEqual("Num Misses", Stats.NumMisses, int64(2));
+			Done.Execute();
+		});
+
+		LatentIt("Shares loads that are in flight", [this](const auto& Done)
+		{
+			SD::TExpectedFutureCache<int32, int32> Cache;
+			SD::TExpectedPromise<int32> Promise;
+			int32 NumRequests = 0;
+
+			const auto Factory = [&NumRequests, &Promise]()
+			{
+				++NumRequests;
+				return Promise.GetFuture();
+			};
+
+			SD::TExpectedFuture<int32> First = Cache.Get(1, Factory);
+			SD::TExpectedFuture<int32> Second = Cache.Get(1, Factory);
+			Promise.SetValue(5);
+
+			TestEqual("Num Requests", NumRequests, 1);
+			TestTrue("First is ready", First.IsReady() && *First.Get() == 5);
+			TestTrue("Second is ready", Second.IsReady() && *Second.Get() == 5);
+			TestEqual("Cached", *Cache.Get(1, Factory).Get(), 5);
+			Done.Execute();
+		});
+
+		LatentIt("Evicts the least recently used values", [this](const auto& Done)
+		{
+			SD::TExpectedFutureCache<int32, int32>::FSettings Settings;
+			Settings.MaxEntries = 2;
+			SD::TExpectedFutureCache<int32, int32> Cache(Settings);
+			TArray<int32> Requested;
+
+			const auto Get = [&Cache, &Requested](const int32 Key)
+			{
+				Cache.Get(Key, [&Requested, Key]()
+				{
+					Requested.Add(Key);
+					return SD::MakeReadyFuture<int32>(int32(Key));
+				});
+			};
+
+			Get(1);
+			Get(2);
+			Get(1);
+			Get(3);
+			Get(1);
+			Get(2);
+
+			TestEqual("Requested", Requested, TArray<int32>({ 1, 2, 3, 2 }));
+			TestEqual("Num Evictions", Cache.GetStats().NumEvictions, int64(2));
+			TestEqual("Num Entries", Cache.GetStats().NumEntries, 2);
+			Done.Execute();
+		});
+
+		LatentIt("Stays within the cost budget", [this](const auto& Done)
+		{
+			SD::TExpectedFutureCache<int32, int32>::FSettings Settings;
+			Settings.MaxCost = 10;
+			Settings.GetCost = [](const int32 Value)
+			{
+				return int64(Value);
+			};
+			SD::TExpectedFutureCache<int32, int32> Cache(Settings);
+
+			Cache.Get(1, []() { return SD::MakeReadyFuture<int32>(4); });
+			Cache.Get(2, []() { return SD::MakeReadyFuture<int32>(4); });
+			TestEqual("Total Cost", Cache.GetStats().TotalCost, int64(8));
+
+			Cache.Get(3, []() { return SD::MakeReadyFuture<int32>(6); });
+			TestEqual("Total Cost after eviction", Cache.GetStats().TotalCost, int64(10));
+			TestEqual("Num Evictions", Cache.GetStats().NumEvictions, int64(1));
+			Done.Execute();
+		});
+
+		LatentIt("Only caches errors with a negative cache error code", [this](const auto& Done)
+		{
+			SD::TExpectedFutureCache<int32, int32>::FSettings Settings;
+			Settings.NegativeCacheErrorCodes = { ErrorCode };
+			SD::TExpectedFutureCache<int32, int32> Cache(Settings);
+			int32 NumRequests = 0;
+
+			const auto MakeFactory = [&NumRequests](const int32 Code)
+			{
+				return [&NumRequests, Code]()
+				{
+					++NumRequests;
+					return SD::MakeErrorFuture<int32>(SD::Error(Code));
+				};
+			};
+
+			Cache.Get(1, MakeFactory(ErrorCode));
+			SD::TExpectedFuture<int32> NegativeHit = Cache.Get(1, MakeFactory(ErrorCode));
+			TestTrue("Negative hit is an error", NegativeHit.IsReady() && NegativeHit.Get().IsError());
+			TestEqual("Num Requests for a negative cached error", NumRequests, 1);
+
+			Cache.Get(2, MakeFactory(ErrorCode + 1));
+			Cache.Get(2, MakeFactory(ErrorCode + 1));
+			TestEqual("Num Requests for other errors", NumRequests, 3);
+			Done.Execute();
+		});
+
+		LatentIt("Returns stale values while revalidating", [this](const auto& Done)
+		{
+			SD::TExpectedFutureCache<int32, int32>::FSettings Settings;
+			Settings.TimeToLiveSeconds = 0.01f;
+			Settings.bStaleWhileRevalidate = true;
+			SD::TExpectedFutureCache<int32, int32> Cache(Settings);
+
+			SD::TExpectedPromise<int32> RefreshPromise;
+			int32 NumRefreshes = 0;
+			const auto Refresh = [&NumRefreshes, &RefreshPromise]()
+			{
+				++NumRefreshes;
+				return RefreshPromise.GetFuture();
+			};
+
+			Cache.Get(1, []() { return SD::MakeReadyFuture<int32>(1); });
+			FPlatformProcess::Sleep(0.02f);
+
+			SD::TExpectedFuture<int32> Stale = Cache.Get(1, Refresh);
+			TestTrue("Stale value is ready", Stale.IsReady() && *Stale.Get() == 1);
+			Cache.Get(1, Refresh);
+			TestEqual("Num Refreshes", NumRefreshes, 1);
+
+			RefreshPromise.SetValue(2);
+			TestEqual("Refreshed", *Cache.Get(1, Refresh).Get(), 2);
+			TestEqual("Num Stale Hits", Cache.GetStats().NumStaleHits, int64(2));
+			Done.Execute();
+		});
+	});
+}
+
+#endif //WITH_DEV_AUTOMATION_TESTS
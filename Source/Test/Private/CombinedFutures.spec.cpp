@@ -26,6 +26,8 @@ class FFutureTestSpec_Combined : public FFutureTestSpec
 
 	static constexpr int32 ErrorContext = 0xbaadf00d;
 	static constexpr int32 ErrorCode = 0xdeadbeef;
+	static constexpr int32 NumStressFutures = 4096;
+	static constexpr int32 NumParallelItems = 50000;
 };
 
 
@@ -65,6 +67,803 @@ void FFutureTestSpec_Combined::Define()
 							Done.Execute();
 						});
 			});
+
+		LatentIt("Preserves the order of the results", [this](const auto& Done)
+			{
+				TArray<SD::TExpectedPromise<int32>> Promises;
+				Promises.SetNum(3);
+
+				SD::WhenAll<int32>({ Promises[0].GetFuture(), Promises[1].GetFuture(), Promises[2].GetFuture() })
+					.Then([this, Done](const TArray<int32>& Result)
+						{
+							TestEqual("Num Results", Result.Num(), 3);
+							TestTrue("Results are in order", Result.Num() == 3 && Result[0] == 1 && Result[1] == 2 && Result[2] == 3);
+							Done.Execute();
+						});
+
+				Promises[2].SetValue(3);
+				Promises[0].SetValue(1);
+				Promises[1].SetValue(2);
+			});
+
+		LatentIt("Fast fail completes before the other futures", [this](const auto& Done)
+			{
+				SD::TExpectedPromise<int32> PendingPromise;
+
+				SD::TExpectedFuture<TArray<int32>> Future = SD::WhenAll<int32>({ PendingPromise.GetFuture(), SD::MakeErrorFuture<int32>(SD::Error(ErrorCode, ErrorContext)) }, SD::EFailMode::Fast);
+				TestTrue("Completed before the pending future", Future.IsReady());
+
+				Future.Then([this, Done](const SD::TExpected<TArray<int32>>& Expected)
+						{
+							TestTrue("Result is an error", Expected.IsError());
+							TestEqual("Error Code", Expected.GetError()->GetErrorCode(), ErrorCode);
+							Done.Execute();
+						});
+
+				PendingPromise.SetValue(1);
+			});
+
+		LatentIt("Keeps every result in place when futures complete on many threads", FTimespan::FromSeconds(10.0), [this](const auto& Done)
+			{
+				const SD::FExpectedFutureOptions ThreadPoolOptions(SD::EExpectedFutureExecutionPolicy::ThreadPool);
+
+				TArray<SD::TExpectedFuture<int32>> Futures;
+				Futures.Reserve(NumStressFutures);
+				for (int32 Index = 0; Index < NumStressFutures; ++Index)
+				{
+					Futures.Add(SD::Async([Index]()
+					{
+						return Index;
+					}, ThreadPoolOptions));
+				}
+
+				SD::WhenAll(Futures)
+					.Then([this, Done](const TArray<int32>& Result)
+						{
+							bool bInOrder = Result.Num() == NumStressFutures;
+							for (int32 Index = 0; bInOrder && Index < NumStressFutures; ++Index)
+							{
+								bInOrder = Result[Index] == Index;
+							}
+
+							TestTrue("Results are complete and in order", bInOrder);
+							Done.Execute();
+						});
+			});
+
+		LatentIt("Void futures fail with the first error", [this](const auto& Done)
+			{
+				SD::TExpectedPromise<void> FirstPromise;
+				SD::TExpectedPromise<void> SecondPromise;
+
+				SD::WhenAll({ FirstPromise.GetFuture(), SecondPromise.GetFuture() })
+					.Then([this, Done](const SD::TExpected<void>& Expected)
+						{
+							TestTrue("Result is an error", Expected.IsError());
+							TestEqual("Error Code", Expected.GetError()->GetErrorCode(), ErrorCode);
+							Done.Execute();
+						});
+
+				SecondPromise.SetValue(SD::Error(ErrorCode, ErrorContext));
+				FirstPromise.SetValue(SD::Error(ErrorCode + 1, ErrorContext));
+			});
+
+		LatentIt("Can combine futures of different types into a tuple", [this](const auto& Done)
+			{
+				SD::TExpectedPromise<FString> StringPromise;
+
+				SD::WhenAll(SD::MakeReadyFuture<int32>(1), StringPromise.GetFuture(), SD::MakeReadyFuture<bool>(true))
+					.Then([this, Done](const TTuple<int32, FString, bool>& Result)
+						{
+							TestEqual("Int", Result.Get<0>(), 1);
+							TestEqual("String", Result.Get<1>(), TEXT("Two"));
+							TestTrue("Bool", Result.Get<2>());
+							Done.Execute();
+						});
+
+				StringPromise.SetValue(FString(TEXT("Two")));
+			});
+
+		LatentIt("Tuple fails with the first error", [this](const auto& Done)
+			{
+				SD::TExpectedPromise<int32> PendingPromise;
+
+				SD::TExpectedFuture<TTuple<int32, FString>> Future = SD::WhenAll(SD::EFailMode::Fast,
+					PendingPromise.GetFuture(), SD::MakeErrorFuture<FString>(SD::Error(ErrorCode, ErrorContext, TEXT("Bad times!"))));
+				TestTrue("Completed before the pending future", Future.IsReady());
+
+				Future.Then([this, Done](const SD::TExpected<TTuple<int32, FString>>& Expected)
+					{
+						TestTrue("Result is an error", Expected.IsError());
+						TestEqual("Captured String", *(Expected.GetError()->GetErrorInfo()), TEXT("Bad times!"));
+						Done.Execute();
+					});
+
+				PendingPromise.SetValue(1);
+			});
+		});
+
+	Describe("WhenAllSettled", [this]()
+		{
+		LatentIt("Returns every result in order with a summary", [this](const auto& Done)
+			{
+				SD::TExpectedPromise<int32> LastPromise;
+
+				SD::WhenAllSettled<int32>({
+					LastPromise.GetFuture(),
+					SD::MakeErrorFuture<int32>(SD::Error(ErrorCode, ErrorContext)),
+					SD::MakeReadyFuture<int32>(2),
+					SD::MakeReadyFuture<int32>(SD::MakeCancelledExpected<int32>()) })
+					.Then([this, Done](const SD::TWhenAllSettledResult<int32>& Settled)
+						{
+							TestEqual("Num Results", Settled.Results.Num(), 4);
+							TestEqual("First Value", *Settled.Results[0], 1);
+							TestEqual("Error Code", Settled.Results[1].GetError()->GetErrorCode(), ErrorCode);
+							TestEqual("Third Value", *Settled.Results[2], 2);
+							TestTrue("Fourth is cancelled", Settled.Results[3].IsCancelled());
+
+							TestEqual("Num Completed", Settled.Summary.GetNum(SD::EExpectedResultState::Completed), 2);
+							TestEqual("Num Errors", Settled.Summary.GetNum(SD::EExpectedResultState::Error), 1);
+							TestEqual("Num Cancelled", Settled.Summary.GetNum(SD::EExpectedResultState::Cancelled), 1);
+							TestTrue("Has Failures", Settled.Summary.HasFailures());
+							Done.Execute();
+						});
+
+				LastPromise.SetValue(1);
+			});
+
+		LatentIt("Settles void futures", [this](const auto& Done)
+			{
+				SD::WhenAllSettled<void>({ SD::MakeReadyFuture(), SD::MakeReadyFuture() })
+					.Then([this, Done](const SD::TWhenAllSettledResult<void>& Settled)
+						{
+							TestEqual("Num Completed", Settled.Summary.GetNum(SD::EExpectedResultState::Completed), 2);
+							TestFalse("Has Failures", Settled.Summary.HasFailures());
+							Done.Execute();
+						});
+			});
+		});
+
+	Describe("WhenN", [this]()
+		{
+		LatentIt("Completes once enough futures succeed", [this](const auto& Done)
+			{
+				TArray<SD::TExpectedPromise<int32>> Promises;
+				Promises.SetNum(4);
+
+				SD::TExpectedFuture<TArray<int32>> Future = SD::WhenN<int32>({ Promises[0].GetFuture(), Promises[1].GetFuture(), Promises[2].GetFuture(), Promises[3].GetFuture() }, 2);
+
+				Promises[0].SetValue(SD::Error(ErrorCode, ErrorContext));
+				Promises[2].SetValue(3);
+				TestFalse("Not complete with a single success", Future.IsReady());
+				Promises[1].SetValue(2);
+				TestTrue("Complete without the last future", Future.IsReady());
+
+				Future.Then([this, Done](const TArray<int32>& Result)
+					{
+						TestTrue("Values in the order they succeeded", Result.Num() == 2 && Result[0] == 3 && Result[1] == 2);
+						Done.Execute();
+					});
+			});
+
+		LatentIt("Fails as soon as success becomes impossible", [this](const auto& Done)
+			{
+				SD::TExpectedPromise<int32> PendingPromise;
+
+				SD::TExpectedFuture<TArray<int32>> Future = SD::WhenN<int32>({
+					SD::MakeErrorFuture<int32>(SD::Error(ErrorCode, ErrorContext)),
+					SD::MakeErrorFuture<int32>(SD::Error(ErrorCode, ErrorContext)),
+					PendingPromise.GetFuture() }, 2);
+				TestTrue("Completed before the pending future", Future.IsReady());
+
+				Future.Then([this, Done](const SD::TExpected<TArray<int32>>& Expected)
+					{
+						TestTrue("Result is an error", Expected.IsError());
+						TestEqual("Error Code", Expected.GetError()->GetErrorCode(), ErrorCode);
+						Done.Execute();
+					});
+
+				PendingPromise.SetValue(1);
+			});
+
+		LatentIt("Cancels the futures that are still running", [this](const auto& Done)
+			{
+				SD::TExpectedPromise<int32> NeverSetPromise;
+				const SD::SharedCancellationHandleRef StragglerHandle = SD::CreateCancellationHandle();
+				const SD::TExpectedFuture<int32> Straggler = NeverSetPromise.GetFuture().Then([](int32 Value)
+				{
+					return Value;
+				}, SD::FExpectedFutureOptions(StragglerHandle));
+
+				SD::WhenN<int32>({ SD::MakeReadyFuture<int32>(1), Straggler }, 1, { SD::CreateCancellationHandle(), StragglerHandle })
+					.Then([this, Done, Straggler](const TArray<int32>& Result)
+						{
+							TestEqual("Num Values", Result.Num(), 1);
+							TestTrue("Straggler is cancelled", Straggler.IsReady() && Straggler.Get().IsCancelled());
+							Done.Execute();
+						});
+			});
+		});
+
+	Describe("ParallelMap", [this]()
+		{
+		LatentIt("Maps every element in order", FTimespan::FromSeconds(10.0), [this](const auto& Done)
+			{
+				TArray<int32> Input;
+				Input.SetNum(NumParallelItems);
+				for (int32 Index = 0; Index < NumParallelItems; ++Index)
+				{
+					Input[Index] = Index;
+				}
+
+				SD::ParallelMap(MoveTemp(Input), [](const int32 Value)
+				{
+					return int64(Value) * 2;
+				}, SD::FExpectedFutureOptions(SD::EExpectedFutureExecutionPolicy::ThreadPool))
+					.Then([this, Done](const TArray<int64>& Result)
+						{
+							bool bMapped = Result.Num() == NumParallelItems;
+							for (int32 Index = 0; bMapped && Index < NumParallelItems; ++Index)
+							{
+								bMapped = Result[Index] == int64(Index) * 2;
+							}
+
+							TestTrue("Every element is mapped in order", bMapped);
+							Done.Execute();
+						});
+			});
+
+		LatentIt("ParallelForEach visits every element once", FTimespan::FromSeconds(10.0), [this](const auto& Done)
+			{
+				TArray<int32> Input;
+				Input.Init(1, NumParallelItems);
+
+				const auto Sum = MakeShared<std::atomic<int32>, ESPMode::ThreadSafe>(0);
+				SD::ParallelForEach(MoveTemp(Input), [Sum](const int32 Value)
+				{
+					Sum->fetch_add(Value);
+				})
+					.Then([this, Done, Sum]()
+						{
+							TestEqual("Sum", Sum->load(), NumParallelItems);
+							Done.Execute();
+						});
+			});
+
+		LatentIt("Skips the remaining chunks once cancelled", FTimespan::FromSeconds(10.0), [this](const auto& Done)
+			{
+				TArray<int32> Input;
+				Input.Init(1, NumParallelItems);
+
+				const SD::SharedCancellationHandleRef CancellationHandle = SD::CreateCancellationHandle();
+				const auto NumCalls = MakeShared<std::atomic<int32>, ESPMode::ThreadSafe>(0);
+
+				SD::ParallelMap(MoveTemp(Input), [NumCalls, CancellationHandle](const int32 Value)
+				{
+					if (NumCalls->fetch_add(1) == 0)
+					{
+						CancellationHandle->Cancel();
+					}
+					return Value;
+				}, SD::FExpectedFutureOptions(CancellationHandle))
+					.Then([this, Done, NumCalls](const SD::TExpected<TArray<int32>>& Expected)
+						{
+							TestTrue("Result is cancelled", Expected.IsCancelled());
+							TestTrue("Not every element was mapped", NumCalls->load() < NumParallelItems);
+							Done.Execute();
+						});
+			});
+		});
+
+	Describe("ReduceAsync", [this]()
+		{
+		LatentIt("Keeps the input order when ordered", [this](const auto& Done)
+			{
+				const TCHAR* const Letters[] = { TEXT("a"), TEXT("b"), TEXT("c"), TEXT("d"), TEXT("e"), TEXT("f"), TEXT("g") };
+				constexpr int32 NumLetters = UE_ARRAY_COUNT(Letters);
+
+				TArray<SD::TExpectedPromise<FString>> Promises;
+				TArray<SD::TExpectedFuture<FString>> Futures;
+				Promises.SetNum(NumLetters);
+				for (SD::TExpectedPromise<FString>& Promise : Promises)
+				{
+					Futures.Add(Promise.GetFuture());
+				}
+
+				SD::ReduceAsync(Futures, FString(), [](FString&& Left, FString&& Right)
+				{
+					return Left + Right;
+				})
+					.Then([this, Done](const FString& Result)
+						{
+							TestEqual("Result", Result, TEXT("abcdefg"));
+							Done.Execute();
+						});
+
+				for (const int32 Index : { 4, 0, 6, 2, 1, 5, 3 })
+				{
+					Promises[Index].SetValue(FString(Letters[Index]));
+				}
+			});
+
+		LatentIt("Combines values as they arrive when unordered", FTimespan::FromSeconds(10.0), [this](const auto& Done)
+			{
+				const SD::FExpectedFutureOptions ThreadPoolOptions(SD::EExpectedFutureExecutionPolicy::ThreadPool);
+
+				TArray<SD::TExpectedFuture<int64>> Futures;
+				for (int32 Index = 0; Index < NumStressFutures; ++Index)
+				{
+					Futures.Add(SD::Async([Index]()
+					{
+						return int64(Index);
+					}, ThreadPoolOptions));
+				}
+
+				SD::ReduceAsync(Futures, int64(0), [](int64 Left, int64 Right)
+				{
+					return Left + Right;
+				}, ThreadPoolOptions, SD::EReduceOrder::Unordered)
+					.Then([this, Done](const int64 Result)
+						{
+							TestEqual("Sum", Result, int64(NumStressFutures) * (NumStressFutures - 1) / 2);
+							Done.Execute();
+						});
+			});
+
+		LatentIt("Fails with the first error", [this](const auto& Done)
+			{
+				SD::TExpectedPromise<int32> PendingPromise;
+
+				SD::ReduceAsync<int32>({ SD::MakeReadyFuture<int32>(1), SD::MakeErrorFuture<int32>(SD::Error(ErrorCode, ErrorContext)), PendingPromise.GetFuture() }, 0,
+					[](int32 Left, int32 Right)
+					{
+						return Left + Right;
+					})
+					.Then([this, Done](const SD::TExpected<int32>& Expected)
+						{
+							TestTrue("Result is an error", Expected.IsError());
+							TestEqual("Error Code", Expected.GetError()->GetErrorCode(), ErrorCode);
+							Done.Execute();
+						});
+
+				PendingPromise.SetValue(2);
+			});
+
+		LatentIt("Results in the identity without any futures", [this](const auto& Done)
+			{
+				SD::ReduceAsync<int32>({}, 1, [](int32 Left, int32 Right)
+				{
+					return Left * Right;
+				})
+					.Then([this, Done](const int32 Result)
+						{
+							TestEqual("Result", Result, 1);
+							Done.Execute();
+						});
+			});
+		});
+
+	Describe("MapConcurrent", [this]()
+		{
+		LatentIt("Keeps at most MaxInFlight operations outstanding", [this](const auto& Done)
+			{
+				constexpr int32 NumInputs = 10;
+				constexpr int32 MaxInFlight = 3;
+
+				TArray<int32> Inputs;
+				for (int32 Index = 0; Index < NumInputs; ++Index)
+				{
+					Inputs.Add(Index);
+				}
+
+				const auto Started = MakeShared<TArray<SD::TExpectedPromise<int32>>, ESPMode::ThreadSafe>();
+				Started->SetNum(NumInputs);
+				const auto NumStarted = MakeShared<int32, ESPMode::ThreadSafe>(0);
+
+				SD::MapConcurrent(MoveTemp(Inputs), MaxInFlight, [Started, NumStarted](const int32 Input)
+				{
+					++*NumStarted;
+					return (*Started)[Input].GetFuture();
+				})
+					.Then([this, Done](const TArray<int32>& Result)
+						{
+							bool bInOrder = Result.Num() == NumInputs;
+							for (int32 Index = 0; bInOrder && Index < NumInputs; ++Index)
+							{
+								bInOrder = Result[Index] == Index * 10;
+							}
+
+							TestTrue("Results are in input order", bInOrder);
+							Done.Execute();
+						});
+
+				TestEqual("Started before any finish", *NumStarted, MaxInFlight);
+
+				for (int32 NumFinished = 0; NumFinished < NumInputs; ++NumFinished)
+				{
+					//Finish the newest outstanding operation first, so they complete out of order
+					int32 Index = *NumStarted - 1;
+					while ((*Started)[Index].IsSet())
+					{
+						--Index;
+					}
+					(*Started)[Index].SetValue(Index * 10);
+					TestTrue("Never more than MaxInFlight outstanding", *NumStarted - (NumFinished + 1) <= MaxInFlight);
+				}
+			});
+
+		LatentIt("Completes operations that finish immediately without recursing", FTimespan::FromSeconds(10.0), [this](const auto& Done)
+			{
+				TArray<int32> Inputs;
+				Inputs.Init(1, NumParallelItems);
+
+				SD::MapConcurrent(MoveTemp(Inputs), 1, [](const int32 Input)
+				{
+					return SD::MakeReadyFuture<int32>(int32(Input));
+				})
+					.Then([this, Done](const TArray<int32>& Result)
+						{
+							TestEqual("Num Values", Result.Num(), NumParallelItems);
+							Done.Execute();
+						});
+			});
+
+		LatentIt("Runs synchronous functions with the execution policy", FTimespan::FromSeconds(10.0), [this](const auto& Done)
+			{
+				TArray<int32> Inputs;
+				for (int32 Index = 0; Index < NumStressFutures; ++Index)
+				{
+					Inputs.Add(Index);
+				}
+
+				const auto NumInFlight = MakeShared<std::atomic<int32>, ESPMode::ThreadSafe>(0);
+				const auto MaxObserved = MakeShared<std::atomic<int32>, ESPMode::ThreadSafe>(0);
+
+				SD::MapConcurrent(MoveTemp(Inputs), 2, [NumInFlight, MaxObserved](const int32 Input)
+				{
+					const int32 InFlight = NumInFlight->fetch_add(1) + 1;
+					int32 Observed = MaxObserved->load();
+					while (InFlight > Observed && !MaxObserved->compare_exchange_weak(Observed, InFlight))
+					{
+					}
+					NumInFlight->fetch_sub(1);
+					return int64(Input) * 2;
+				}, SD::EFailMode::Full, SD::FExpectedFutureOptions(SD::EExpectedFutureExecutionPolicy::ThreadPool))
+					.Then([this, Done, MaxObserved](const TArray<int64>& Result)
+						{
+							bool bInOrder = Result.Num() == NumStressFutures;
+							for (int32 Index = 0; bInOrder && Index < NumStressFutures; ++Index)
+							{
+								bInOrder = Result[Index] == int64(Index) * 2;
+							}
+
+							TestTrue("Results are in input order", bInOrder);
+							TestTrue("Never more than MaxInFlight running", MaxObserved->load() <= 2);
+							Done.Execute();
+						});
+			});
+
+		LatentIt("Stops starting operations after a fast failure", [this](const auto& Done)
+			{
+				const auto NumStarted = MakeShared<int32, ESPMode::ThreadSafe>(0);
+
+				SD::MapConcurrent<int32>({ 0, 1, 2, 3, 4 }, 2, [NumStarted](const int32 Input)
+				{
+					++*NumStarted;
+					return Input == 1
+						? SD::MakeErrorFuture<int32>(SD::Error(ErrorCode, ErrorContext))
+						: SD::MakeReadyFuture<int32>(int32(Input));
+				}, SD::EFailMode::Fast)
+					.Then([this, Done, NumStarted](const SD::TExpected<TArray<int32>>& Expected)
+						{
+							TestTrue("Result is an error", Expected.IsError());
+							TestEqual("Error Code", Expected.GetError()->GetErrorCode(), ErrorCode);
+							TestEqual("Num Started", *NumStarted, 2);
+							Done.Execute();
+						});
+			});
+
+		LatentIt("Stops starting operations once cancelled", [this](const auto& Done)
+			{
+				const SD::SharedCancellationHandleRef CancellationHandle = SD::CreateCancellationHandle();
+				SD::TExpectedPromise<int32> FirstPromise;
+				const auto NumStarted = MakeShared<int32, ESPMode::ThreadSafe>(0);
+
+				SD::MapConcurrent<int32>({ 0, 1, 2 }, 1, [NumStarted, FirstPromise](const int32 Input) mutable
+				{
+					++*NumStarted;
+					return Input == 0 ? FirstPromise.GetFuture() : SD::MakeReadyFuture<int32>(int32(Input));
+				}, SD::EFailMode::Full, SD::FExpectedFutureOptions(CancellationHandle))
+					.Then([this, Done, NumStarted](const SD::TExpected<TArray<int32>>& Expected)
+						{
+							TestTrue("Result is cancelled", Expected.IsCancelled());
+							Done.Execute();
+						});
+
+				CancellationHandle->Cancel();
+				FirstPromise.SetValue(0);
+				TestEqual("Num Started", *NumStarted, 1);
+			});
+
+		LatentIt("Fails with a non-positive MaxInFlight", [this](const auto& Done)
+			{
+				SD::MapConcurrent<int32>({ 1 }, 0, [](const int32 Input)
+				{
+					return Input;
+				})
+					.Then([this, Done](const SD::TExpected<TArray<int32>>& Expected)
+						{
+							TestTrue("Result is an error", Expected.IsError());
+							TestEqual("Error Code", Expected.GetError()->GetErrorCode(), SD::Errors::ERROR_INVALID_ARGUMENT);
+							Done.Execute();
+						});
+			});
+		});
+
+	Describe("Retry", [this]()
+		{
+		LatentIt("Succeeds once an attempt does", [this](const auto& Done)
+			{
+				SD::FRetryPolicy Policy;
+				Policy.MaxAttempts = 3;
+				Policy.InitialDelaySeconds = 0.001f;
+
+				const auto NumAttempts = MakeShared<int32, ESPMode::ThreadSafe>(0);
+				SD::Retry([NumAttempts]()
+				{
+					return ++*NumAttempts < 3
+						? SD::MakeErrorFuture<int32>(SD::Error(ErrorCode, ErrorContext))
+						: SD::MakeReadyFuture<int32>(int32(*NumAttempts));
+				}, Policy)
+					.Then([this, Done, NumAttempts](const SD::TExpected<int32>& Expected)
+						{
+							TestTrue("Result is completed", Expected.IsCompleted());
+							TestEqual("Num Attempts", *NumAttempts, 3);
+							Done.Execute();
+						});
+			});
+
+		LatentIt("Fails with the last error after MaxAttempts", [this](const auto& Done)
+			{
+				SD::FRetryPolicy Policy;
+				Policy.MaxAttempts = 4;
+				Policy.InitialDelaySeconds = 0.001f;
+
+				const auto NumAttempts = MakeShared<int32, ESPMode::ThreadSafe>(0);
+				SD::Retry([NumAttempts]()
+				{
+					return SD::MakeErrorFuture<int32>(SD::Error(ErrorCode, ++*NumAttempts));
+				}, Policy)
+					.Then([this, Done, NumAttempts](const SD::TExpected<int32>& Expected)
+						{
+							TestTrue("Result is an error", Expected.IsError());
+							TestEqual("Error Context", Expected.GetError()->GetErrorContext(), 4);
+							TestEqual("Num Attempts", *NumAttempts, 4);
+							Done.Execute();
+						});
+			});
+
+		LatentIt("Only retries errors accepted by ShouldRetry", [this](const auto& Done)
+			{
+				SD::FRetryPolicy Policy;
+				Policy.InitialDelaySeconds = 0.001f;
+				Policy.ShouldRetry = [](const SD::Error& Error)
+				{
+					return Error.GetErrorCode() != ErrorCode;
+				};
+
+				const auto NumAttempts = MakeShared<int32, ESPMode::ThreadSafe>(0);
+				SD::Retry([NumAttempts]()
+				{
+					++*NumAttempts;
+					return SD::MakeErrorFuture<void>(SD::Error(ErrorCode, ErrorContext));
+				}, Policy)
+					.Then([this, Done, NumAttempts](const SD::TExpected<void>& Expected)
+						{
+							TestTrue("Result is an error", Expected.IsError());
+							TestEqual("Num Attempts", *NumAttempts, 1);
+							Done.Execute();
+						});
+			});
+
+		LatentIt("Stops retrying once cancelled", [this](const auto& Done)
+			{
+				const SD::SharedCancellationHandleRef CancellationHandle = SD::CreateCancellationHandle();
+				SD::FRetryPolicy Policy;
+				Policy.InitialDelaySeconds = 0.001f;
+
+				const auto NumAttempts = MakeShared<int32, ESPMode::ThreadSafe>(0);
+				SD::Retry([NumAttempts]()
+				{
+					++*NumAttempts;
+					return SD::MakeErrorFuture<int32>(SD::Error(ErrorCode, ErrorContext));
+				}, Policy, SD::FExpectedFutureOptions(CancellationHandle))
+					.Then([this, Done, NumAttempts](const SD::TExpected<int32>& Expected)
+						{
+							TestTrue("Result is cancelled", Expected.IsCancelled());
+							TestEqual("Num Attempts", *NumAttempts, 1);
+							Done.Execute();
+						});
+
+				CancellationHandle->Cancel();
+			});
+
+		LatentIt("Backs off exponentially up to the maximum delay", [this](const auto& Done)
+			{
+				SD::FRetryPolicy Policy;
+				Policy.InitialDelaySeconds = 1.0f;
+				Policy.MaxDelaySeconds = 5.0f;
+				Policy.bFullJitter = false;
+
+				TestEqual("First delay", Policy.GetDelaySeconds(1), 1.0f);
+				TestEqual("Second delay", Policy.GetDelaySeconds(2), 2.0f);
+				TestEqual("Third delay", Policy.GetDelaySeconds(3), 4.0f);
+				TestEqual("Capped delay", Policy.GetDelaySeconds(10), 5.0f);
+
+				Policy.bFullJitter = true;
+				bool bInRange = true;
+				for (int32 Index = 0; Index < 100; ++Index)
+				{
+					const float Delay = Policy.GetDelaySeconds(2);
+					bInRange &= Delay >= 0.0f && Delay <= 2.0f;
+				}
+				TestTrue("Jittered delays are within the backoff", bInRange);
+
+				Done.Execute();
+			});
+		});
+
+	Describe("WithTimeout", [this]()
+		{
+		LatentIt("Completes with the future's result if it finishes in time", [this](const auto& Done)
+			{
+				SD::TExpectedPromise<int32> Promise;
+				const SD::SharedCancellationHandleRef CancellationHandle = SD::CreateCancellationHandle();
+
+				SD::WithTimeout(Promise.GetFuture(), 10.0f, CancellationHandle)
+					.Then([this, Done](const SD::TExpected<int32>& Expected)
+						{
+							TestTrue("Result is completed", Expected.IsCompleted());
+							TestEqual("Value", *Expected, 5);
+							Done.Execute();
+						});
+
+				Promise.SetValue(5);
+			});
+
+		LatentIt("Times out and cancels the work", [this](const auto& Done)
+			{
+				SD::TExpectedPromise<int32> Promise;
+				const SD::SharedCancellationHandleRef CancellationHandle = SD::CreateCancellationHandle();
+				CancellationHandle->AddPromise(Promise.GetCancellablePromise());
+
+				SD::WithTimeout(Promise.GetFuture(), 0.01f, CancellationHandle)
+					.Then([this, Done, Promise](const SD::TExpected<int32>& Expected)
+						{
+							TestTrue("Result is an error", Expected.IsError());
+							TestEqual("Error Code", Expected.GetError()->GetErrorCode(), SD::Errors::ERROR_TIMED_OUT);
+							TestTrue("Work is cancelled", Promise.IsSet());
+							Done.Execute();
+						});
+			});
+
+		LatentIt("Passes through futures that are already ready", [this](const auto& Done)
+			{
+				SD::TExpectedFuture<int32> Future = SD::WithTimeout(SD::MakeReadyFuture<int32>(7), 0.0f);
+				TestTrue("Result is ready", Future.IsReady());
+
+				Future.Then([this, Done](const int32 Result)
+					{
+						TestEqual("Value", Result, 7);
+						Done.Execute();
+					});
+			});
+		});
+
+	Describe("Hedge", [this]()
+		{
+		LatentIt("Does not hedge requests that complete in time", [this](const auto& Done)
+			{
+				const SD::FHedgeStats StatsBefore = SD::GetHedgeStats();
+				const auto NumAttempts = MakeShared<int32, ESPMode::ThreadSafe>(0);
+
+				SD::Hedge([NumAttempts](const SD::SharedCancellationHandleRef& CancellationHandle)
+				{
+					++*NumAttempts;
+					return SD::MakeReadyFuture<int32>(1);
+				}, 0.01f, 2)
+					.Then([this, Done, NumAttempts, StatsBefore](const int32 Result)
+						{
+							const SD::FHedgeStats StatsAfter = SD::GetHedgeStats();
+							TestEqual("Value", Result, 1);
+							TestEqual("Num Attempts", *NumAttempts, 1);
+							TestEqual("Num Requests", StatsAfter.NumRequests - StatsBefore.NumRequests, int64(1));
+							TestEqual("Num Hedges Started", StatsAfter.NumHedgesStarted - StatsBefore.NumHedgesStarted, int64(0));
+							Done.Execute();
+						});
+			});
+
+		LatentIt("Takes the first result and cancels the rest", [this](const auto& Done)
+			{
+				const SD::FHedgeStats StatsBefore = SD::GetHedgeStats();
+				SD::TExpectedPromise<int32> SlowPromise;
+				const auto NumAttempts = MakeShared<int32, ESPMode::ThreadSafe>(0);
+
+				SD::Hedge([SlowPromise, NumAttempts](const SD::SharedCancellationHandleRef& CancellationHandle) mutable
+				{
+					if (++*NumAttempts > 1)
+					{
+						return SD::MakeReadyFuture<int32>(2);
+					}
+					CancellationHandle->AddPromise(SlowPromise.GetCancellablePromise());
+					return SlowPromise.GetFuture();
+				}, 0.01f, 1)
+					.Then([this, Done, SlowPromise, StatsBefore](const int32 Result)
+						{
+							const SD::FHedgeStats StatsAfter = SD::GetHedgeStats();
+							TestEqual("Value", Result, 2);
+							TestTrue("Slow request is cancelled", SlowPromise.IsSet());
+							TestEqual("Num Hedges Started", StatsAfter.NumHedgesStarted - StatsBefore.NumHedgesStarted, int64(1));
+							TestEqual("Num Hedges Won", StatsAfter.NumHedgesWon - StatsBefore.NumHedgesWon, int64(1));
+							Done.Execute();
+						});
+			});
+
+		LatentIt("Starts at most MaxHedges duplicates", FTimespan::FromSeconds(2.0), [this](const auto& Done)
+			{
+				const auto Promises = MakeShared<TArray<SD::TExpectedPromise<int32>>, ESPMode::ThreadSafe>();
+
+				SD::TExpectedFuture<int32> Result = SD::Hedge([Promises](const SD::SharedCancellationHandleRef& CancellationHandle)
+				{
+					return Promises->AddDefaulted_GetRef().GetFuture();
+				}, 0.001f, 2);
+
+				SD::WaitAsync(0.5f).Then([this, Done, Promises, Result]()
+					{
+						TestEqual("Num Attempts", Promises->Num(), 3);
+						(*Promises)[0].SetValue(3);
+						TestTrue("Result is ready", Result.IsReady() && *Result.Get() == 3);
+						Done.Execute();
+					}, SD::FExpectedFutureOptions(ENamedThreads::GameThread));
+			});
+
+		LatentIt("Waits for a duplicate when the original fails", [this](const auto& Done)
+			{
+				const auto NumAttempts = MakeShared<int32, ESPMode::ThreadSafe>(0);
+
+				SD::Hedge([this, NumAttempts](const SD::SharedCancellationHandleRef& CancellationHandle)
+				{
+					if (++*NumAttempts > 1)
+					{
+						return SD::MakeReadyFuture<int32>(2);
+					}
+					return SD::MakeErrorFuture<int32>(SD::Error(ErrorCode, ErrorContext));
+				}, 0.01f, 1)
+					.Then([this, Done, NumAttempts](const SD::TExpected<int32>& Expected)
+						{
+							TestTrue("Result is completed", Expected.IsCompleted());
+							TestEqual("Value", *Expected, 2);
+							TestEqual("Num Attempts", *NumAttempts, 2);
+							Done.Execute();
+						});
+			});
+
+		LatentIt("Fails with the first error once every attempt has failed", [this](const auto& Done)
+			{
+				const auto NumAttempts = MakeShared<int32, ESPMode::ThreadSafe>(0);
+
+				SD::Hedge([this, NumAttempts](const SD::SharedCancellationHandleRef& CancellationHandle)
+				{
+					return SD::MakeErrorFuture<int32>(SD::Error(ErrorCode, ++*NumAttempts));
+				}, 0.01f, 2)
+					.Then([this, Done, NumAttempts](const SD::TExpected<int32>& Expected)
+						{
+							TestTrue("Result is an error", Expected.IsError());
+							TestEqual("Num Attempts", *NumAttempts, 3);
+							TestEqual("Error is from the original", Expected.GetError()->GetErrorContext(), 1);
+							Done.Execute();
+						});
+			});
 		});
 
 	Describe("WhenAny", [this]()
@@ -100,6 +899,49 @@ void FFutureTestSpec_Combined::Define()
 				FirstPromise.SetValue(SD::Error(ErrorCode, ErrorContext, TEXT("Bad times!")));
 				SecondPromise.SetValue(1);
 			});
+
+		LatentIt("Cancel others cancels every future but the first to complete", [this](const auto& Done)
+			{
+				SD::TExpectedPromise<int32> NeverSetPromise;
+				TArray<SD::TExpectedFuture<int32>> Losers;
+
+				SD::WhenAnyCancelOthers(3, [&NeverSetPromise, &Losers](int32 Index, const SD::SharedCancellationHandleRef& CancellationHandle) -> SD::TExpectedFuture<int32>
+					{
+						if (Index == 1)
+						{
+							return SD::MakeReadyFuture<int32>(int32(Index));
+						}
+
+						SD::TExpectedFuture<int32> Loser = NeverSetPromise.GetFuture().Then([](int32 Value)
+						{
+							return Value;
+						}, SD::FExpectedFutureOptions(CancellationHandle));
+
+						Losers.Add(Loser);
+						return Loser;
+					})
+					.Then([this, Done, Losers](const SD::TWhenAnyResult<int32>& Result)
+						{
+							TestEqual("Winning Index", Result.Index, 1);
+							TestEqual("Value", Result.Value, 1);
+							for (const SD::TExpectedFuture<int32>& Loser : Losers)
+							{
+								TestTrue("Other future is cancelled", Loser.IsReady() && Loser.Get().IsCancelled());
+							}
+							Done.Execute();
+						});
+			});
+
+		LatentIt("Cancel others needs a cancellation handle for each future", [this](const auto& Done)
+			{
+				SD::WhenAnyCancelOthers<int32>({ SD::MakeReadyFuture<int32>(1) }, {})
+					.Then([this, Done](const SD::TExpected<SD::TWhenAnyResult<int32>>& Expected)
+						{
+							TestTrue("Result is an error", Expected.IsError());
+							TestEqual("Error Code", Expected.GetError()->GetErrorCode(), SD::Errors::ERROR_INVALID_ARGUMENT);
+							Done.Execute();
+						});
+			});
 	});
 }
 
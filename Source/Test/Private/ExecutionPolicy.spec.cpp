@@ -140,6 +140,122 @@ void FFutureTestSpec_ExecutionPolicy::Define()
 			Done.Execute();
 		});
 	});
+
+	LatentIt("Runs Inline continuations when the antecedent is set", [this](const auto& Done)
+	{
+		SD::TExpectedPromise<int32> Promise;
+		bool bContinuationCalled = false;
+
+		SD::TExpectedFuture<int32> Future = Promise.GetFuture()
+		.Then([&bContinuationCalled](int32 Result)
+		{
+			bContinuationCalled = true;
+			return Result + 1;
+		}, SD::FExpectedFutureOptionsBuilder()
+			.SetExecutionPolicy(SD::EExpectedFutureExecutionPolicy::Inline)
+			.Build());
+
+		TestFalse("Continuation called before value set", bContinuationCalled);
+
+		Promise.SetValue(1);
+
+		TestTrue("Continuation called from SetValue", bContinuationCalled);
+		TestTrue("Future is ready", Future.IsReady());
+		TestEqual("Value", *Future.Get(), 2);
+		Done.Execute();
+	});
+
+	LatentIt("Runs Inline continuations straight away on a ready future", [this](const auto& Done)
+	{
+		const ENamedThreads::Type CurrentThread = FTaskGraphInterface::Get().GetCurrentThreadIfKnown();
+
+		SD::TExpectedFuture<ENamedThreads::Type> Future = SD::MakeReadyFuture()
+		.Then([]()
+		{
+			return FTaskGraphInterface::Get().GetCurrentThreadIfKnown();
+		}, SD::FExpectedFutureOptionsBuilder()
+			.SetExecutionPolicy(SD::EExpectedFutureExecutionPolicy::Inline)
+			.Build());
+
+		TestTrue("Future is ready", Future.IsReady());
+		TestEqual("Execution thread", *Future.Get(), CurrentThread);
+		Done.Execute();
+	});
+
+	LatentIt("Can run a long Inline chain without overflowing the stack", [this](const auto& Done)
+	{
+		static constexpr int32 ChainLength = 10000;
+
+		SD::TExpectedPromise<int32> Promise;
+		SD::TExpectedFuture<int32> Future = Promise.GetFuture();
+
+		const SD::FExpectedFutureOptions InlineOptions(SD::EExpectedFutureExecutionPolicy::Inline);
+		for (int32 i = 0; i < ChainLength; ++i)
+		{
+			Future = Future.Then([](int32 Value)
+			{
+				return Value + 1;
+			}, InlineOptions);
+		}
+
+		Promise.SetValue(0);
+
+		TestTrue("Chain completed", Future.IsReady());
+		TestEqual("Value", *Future.Get(), ChainLength);
+		Done.Execute();
+	});
+
+	LatentIt("Can nest Inline continuations on ready futures without overflowing the stack", [this](const auto& Done)
+	{
+		static constexpr int32 NestingDepth = 100000;
+
+		//Each continuation adds the next one to a ready future from inside itself, so they would all be on the stack
+		//at once if they were run straight away
+		int32 DeepestValue = 0;
+		TFunction<void(int32)> ThenNested;
+		ThenNested = [&ThenNested, &DeepestValue](int32 Depth)
+		{
+			SD::MakeReadyFuture<int32>(Depth)
+			.Then([&ThenNested, &DeepestValue](int32 Value)
+			{
+				DeepestValue = Value;
+				if (Value < NestingDepth)
+				{
+					ThenNested(Value + 1);
+				}
+			}, SD::FExpectedFutureOptions(SD::EExpectedFutureExecutionPolicy::Inline));
+		};
+
+		ThenNested(0);
+
+		TestEqual("Every continuation ran before the first Then returned", DeepestValue, NestingDepth);
+		Done.Execute();
+	});
+
+	LatentIt("Does not occupy pool threads with ThreadPool continuations that are waiting", [this](const auto& Done)
+	{
+		const SD::FExpectedFutureOptions ThreadPoolOptions(SD::EExpectedFutureExecutionPolicy::ThreadPool);
+		const int32 NumContinuations = GThreadPool->GetNumThreads() * 2;
+
+		SD::TExpectedPromise<void> Promise;
+		TArray<SD::TExpectedFuture<void>> Futures;
+		for (int32 i = 0; i < NumContinuations; ++i)
+		{
+			Futures.Add(Promise.GetFuture().Then([]() {}, ThreadPoolOptions));
+		}
+
+		//If the continuations above were each holding a pool thread, this would never get to run
+		SD::Async([Promise]() mutable
+		{
+			Promise.SetValue();
+		}, ThreadPoolOptions);
+
+		SD::WhenAll(Futures).Then([this, Done](SD::TExpected<void> Expected)
+		{
+			TestTrue("All continuations completed", Expected.IsCompleted());
+			Done.Execute();
+		});
+	});
 }
 
 #endif //WITH_DEV_AUTOMATION_TESTS
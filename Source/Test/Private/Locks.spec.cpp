@@ -0,0 +1,200 @@
+// Copyright 2020 Splash Damage, Ltd. - All Rights Reserved.
+
+#include <CoreMinimal.h>
+#include <FutureExtensions.h>
+
+#include "Helpers/TestHelpers.h"
+
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+/************************************************************************/
+/* FUTURE LOCKS SPEC                                                    */
+/************************************************************************/
+
+class FFutureTestSpec_Locks : public FFutureTestSpec
+{
+	GENERATE_SPEC(FFutureTestSpec_Locks, "FutureExtensions.Locks",
+		EAutomationTestFlags::ProductFilter |
+		EAutomationTestFlags::EditorContext |
+		EAutomationTestFlags::ServerContext
+	);
+
+	FFutureTestSpec_Locks() : FFutureTestSpec()
+	{
+		DefaultTimeout = FTimespan::FromSeconds(0.2);
+	}
+};
+
+
+void FFutureTestSpec_Locks::Define()
+{
+	Describe("Mutex", [this]()
+	{
+		LatentIt("Acquires straight away when free", [this](const auto& Done)
+		{
+			SD::FAsyncMutex Mutex;
+			SD::TExpectedFuture<SD::FLockGuard> Acquired = Mutex.Acquire();
+
+			TestTrue("Ready", Acquired.IsReady());
+			TestTrue("Guard is valid", Acquired.Get().IsCompleted() && (*Acquired.Get()).IsValid());
+			Done.Execute();
+		});
+
+		LatentIt("Hands the lock to waiters in the order they asked for it", [this](const auto& Done)
+		{
+			SD::FAsyncMutex Mutex;
+			SD::FLockGuard Guard = *Mutex.Acquire().Get();
+
+			SD::TExpectedFuture<SD::FLockGuard> First = Mutex.Acquire();
+			SD::TExpectedFuture<SD::FLockGuard> Second = Mutex.Acquire();
+			TestFalse("First waits", First.IsReady());
+
+			Guard.Release();
+			TestTrue("First is handed the lock", First.IsReady());
+			TestFalse("Second still waits", Second.IsReady());
+
+			First = SD::TExpectedFuture<SD::FLockGuard>();
+			TestTrue("Second is handed the lock once every copy of the first guard is gone", Second.IsReady());
+			Done.Execute();
+		});
+
+		LatentIt("Takes a cancelled waiter out of the queue", [this](const auto& Done)
+		{
+			SD::FAsyncMutex Mutex;
+			SD::FLockGuard Guard = *Mutex.Acquire().Get();
+
+			const SD::SharedCancellationHandleRef CancellationHandle = SD::CreateCancellationHandle();
+			SD::TExpectedFuture<SD::FLockGuard> Cancelled = Mutex.Acquire(SD::FExpectedFutureOptions(CancellationHandle));
+			SD::TExpectedFuture<SD::FLockGuard> Waiting = Mutex.Acquire();
+
+			CancellationHandle->Cancel();
+			TestTrue("Cancelled", Cancelled.IsReady() && Cancelled.Get().IsCancelled());
+
+			Guard.Release();
+			TestTrue("Next waiter is handed the lock", Waiting.IsReady() && Waiting.Get().IsCompleted());
+			Done.Execute();
+		});
+
+		LatentIt("Keeps the order of the queue around a cancelled waiter", [this](const auto& Done)
+		{
+			SD::FAsyncMutex Mutex;
+			SD::FLockGuard Guard = *Mutex.Acquire().Get();
+
+			const SD::SharedCancellationHandleRef CancellationHandle = SD::CreateCancellationHandle();
+			SD::TExpectedFuture<SD::FLockGuard> First = Mutex.Acquire();
+			SD::TExpectedFuture<SD::FLockGuard> Cancelled = Mutex.Acquire(SD::FExpectedFutureOptions(CancellationHandle));
+			SD::TExpectedFuture<SD::FLockGuard> Last = Mutex.Acquire();
+
+			CancellationHandle->Cancel();
+			TestTrue("Cancelled", Cancelled.IsReady() && Cancelled.Get().IsCancelled());
+			TestFalse("First still waits", First.IsReady());
+
+			Guard.Release();
+			TestTrue("First is handed the lock", First.IsReady());
+			TestFalse("Last still waits", Last.IsReady());
+
+			First = SD::TExpectedFuture<SD::FLockGuard>();
+			TestTrue("Last is handed the lock", Last.IsReady() && Last.Get().IsCompleted());
+			Done.Execute();
+		});
+
+		LatentIt("Serialises continuations on many threads", FTimespan::FromSeconds(10.0), [this](const auto& Done)
+		{
+			constexpr int32 NumTasks = 1000;
+
+			const auto Mutex = MakeShared<SD::FAsyncMutex, ESPMode::ThreadSafe>();
+			const auto Counter = MakeShared<int32, ESPMode::ThreadSafe>(0);
+			const auto NumInside = MakeShared<std::atomic<int32>, ESPMode::ThreadSafe>(0);
+			const auto bOverlapped = MakeShared<std::atomic<bool>, ESPMode::ThreadSafe>(false);
+
+			TArray<SD::TExpectedFuture<void>> Tasks;
+			for (int32 Index = 0; Index < NumTasks; ++Index)
+			{
+				Tasks.Add(SD::Async([Mutex]()
+				{
+					return Mutex->Acquire();
+				}, SD::FExpectedFutureOptions(SD::EExpectedFutureExecutionPolicy::ThreadPool))
+				.Then([Counter, NumInside, bOverlapped](const SD::FLockGuard& Guard)
+				{
+					if (NumInside->fetch_add(1) != 0)
+					{
+						*bOverlapped = true;
+					}
+					++*Counter;
+					NumInside->fetch_sub(1);
+				}, SD::FExpectedFutureOptions(SD::EExpectedFutureExecutionPolicy::ThreadPool)));
+			}
+
+			SD::WhenAll(Tasks).Then([this, Done, Counter, bOverlapped, NumTasks]()
+			{
+				TestFalse("Never held by two continuations at once", bOverlapped->load());
+				TestEqual("Counter", *Counter, NumTasks);
+				Done.Execute();
+			});
+		});
+	});
+
+	Describe("Semaphore", [this]()
+	{
+		LatentIt("Lets a limited number of guards hold it at once", [this](const auto& Done)
+		{
+			SD::FAsyncSemaphore Semaphore(2);
+			SD::TExpectedFuture<SD::FLockGuard> First = Semaphore.Acquire();
+			SD::TExpectedFuture<SD::FLockGuard> Second = Semaphore.Acquire();
+			SD::TExpectedFuture<SD::FLockGuard> Third = Semaphore.Acquire();
+
+			TestTrue("First two are ready", First.IsReady() && Second.IsReady());
+			TestFalse("Third waits", Third.IsReady());
+
+			Second = SD::TExpectedFuture<SD::FLockGuard>();
+			TestTrue("Third is handed a permit", Third.IsReady());
+			Done.Execute();
+		});
+	});
+
+	Describe("RWLock", [this]()
+	{
+		LatentIt("Shares the lock between readers, but not with a writer", [this](const auto& Done)
+		{
+			SD::FAsyncRWLock Lock;
+			SD::TExpectedFuture<SD::FLockGuard> FirstRead = Lock.AcquireRead();
+			SD::TExpectedFuture<SD::FLockGuard> SecondRead = Lock.AcquireRead();
+			TestTrue("Readers share the lock", FirstRead.IsReady() && SecondRead.IsReady());
+
+			SD::TExpectedFuture<SD::FLockGuard> Write = Lock.AcquireWrite();
+			SD::TExpectedFuture<SD::FLockGuard> LaterRead = Lock.AcquireRead();
+			TestFalse("Writer waits for the readers", Write.IsReady());
+			TestFalse("Later reader waits behind the writer", LaterRead.IsReady());
+
+			FirstRead = SD::TExpectedFuture<SD::FLockGuard>();
+			TestFalse("Writer waits for every reader", Write.IsReady());
+
+			SecondRead = SD::TExpectedFuture<SD::FLockGuard>();
+			TestTrue("Writer is handed the lock", Write.IsReady());
+			TestFalse("Later reader still waits", LaterRead.IsReady());
+
+			Write = SD::TExpectedFuture<SD::FLockGuard>();
+			TestTrue("Later reader is handed the lock", LaterRead.IsReady());
+			Done.Execute();
+		});
+
+		LatentIt("Lets the readers behind a cancelled writer through", [this](const auto& Done)
+		{
+			SD::FAsyncRWLock Lock;
+			SD::TExpectedFuture<SD::FLockGuard> Read = Lock.AcquireRead();
+
+			const SD::SharedCancellationHandleRef CancellationHandle = SD::CreateCancellationHandle();
+			SD::TExpectedFuture<SD::FLockGuard> Write = Lock.AcquireWrite(SD::FExpectedFutureOptions(CancellationHandle));
+			SD::TExpectedFuture<SD::FLockGuard> LaterRead = Lock.AcquireRead();
+			TestFalse("Later reader waits behind the writer", LaterRead.IsReady());
+
+			CancellationHandle->Cancel();
+			TestTrue("Writer is cancelled", Write.IsReady() && Write.Get().IsCancelled());
+			TestTrue("Later reader is handed the lock", LaterRead.IsReady() && LaterRead.Get().IsCompleted());
+			Done.Execute();
+		});
+	});
+}
+
+#endif //WITH_DEV_AUTOMATION_TESTS
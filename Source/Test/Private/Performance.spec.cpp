@@ -0,0 +1,117 @@
+// Copyright 2020 Splash Damage, Ltd. - All Rights Reserved.
+
+#include <CoreMinimal.h>
+#include <FutureExtensions.h>
+
+#include "Helpers/TestHelpers.h"
+
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+/************************************************************************/
+/* FUTURE PERFORMANCE SPEC                                              */
+/************************************************************************/
+
+class FFutureTestSpec_Performance : public FFutureTestSpec
+{
+	GENERATE_SPEC(FFutureTestSpec_Performance, "FutureExtensions.Performance",
+		EAutomationTestFlags::PerfFilter |
+		EAutomationTestFlags::EditorContext |
+		EAutomationTestFlags::ServerContext
+	);
+
+	static constexpr int32 NumIterations = 100000;
+
+	FFutureTestSpec_Performance() : FFutureTestSpec()
+	{
+		DefaultTimeout = FTimespan::FromSeconds(5.0);
+	}
+
+	template<typename F>
+	void Measure(const TCHAR* Name, F&& Body)
+	{
+		const uint64 NumAllocationsBefore = SD::FutureAllocator::GetNumAllocationsOnCurrentThread();
+		const double StartTime = FPlatformTime::Seconds();
+
+		for (int32 i = 0; i < NumIterations; ++i)
+		{
+			Body(i);
+		}
+
+		const double NanosecondsPerIteration = (FPlatformTime::Seconds() - StartTime) * 1e9 / NumIterations;
+		const double AllocationsPerIteration =
+			double(SD::FutureAllocator::GetNumAllocationsOnCurrentThread() - NumAllocationsBefore) / NumIterations;
+
+		AddInfo(FString::Printf(TEXT("%s: %.1f ns, %.2f future allocations per iteration"),
+			Name, NanosecondsPerIteration, AllocationsPerIteration));
+	}
+};
+
+
+void FFutureTestSpec_Performance::Define()
+{
+	LatentIt("Cache hit path", [this](const auto& Done)
+	{
+		const SD::FExpectedFutureOptions InlineOptions(SD::EExpectedFutureExecutionPolicy::Inline);
+		int64 Sum = 0;
+
+		Measure(TEXT("MakeReadyFuture"), [&Sum](int32 Value)
+		{
+			Sum += *SD::MakeReadyFuture<int32>(int32(Value)).Get();
+		});
+
+		Measure(TEXT("MakeReadyFuture + Inline Then"), [&Sum, &InlineOptions](int32 Value)
+		{
+			Sum += *SD::MakeReadyFuture<int32>(int32(Value))
+				.Then([](int32 Result)
+				{
+					return Result + 1;
+				}, InlineOptions)
+				.Get();
+		});
+
+		//The way a ready future was made before MakeReadyFuture built it with the value already in it, as a baseline
+		Measure(TEXT("TExpectedPromise + SetValue + GetFuture"), [&Sum](int32 Value)
+		{
+			SD::TExpectedPromise<int32> Promise;
+			Promise.SetValue(int32(Value));
+			Sum += *Promise.GetFuture().Get();
+		});
+
+		TestNotEqual("Sum", Sum, 0);
+
+		//A ready future and an inline continuation on it should only cost their own states
+		const uint64 NumAllocationsBefore = SD::FutureAllocator::GetNumAllocationsOnCurrentThread();
+		SD::MakeReadyFuture<int32>(1).Then([](int32 Result) { return Result + 1; }, InlineOptions);
+		TestEqual("Allocations for an inline Then on a ready future",
+			SD::FutureAllocator::GetNumAllocationsOnCurrentThread() - NumAllocationsBefore, uint64(2));
+
+		Done.Execute();
+	});
+
+	LatentIt("Dispatched Then on a ready future", [this](const auto& Done)
+	{
+		//Only times the calling thread, which allocates the continuation and hands it to the pool, as a baseline for the
+		//Inline Then above
+		const SD::FExpectedFutureOptions ThreadPoolOptions(SD::EExpectedFutureExecutionPolicy::ThreadPool);
+		TArray<SD::TExpectedFuture<int32>> Futures;
+		Futures.Reserve(NumIterations);
+
+		Measure(TEXT("MakeReadyFuture + ThreadPool Then"), [&Futures, &ThreadPoolOptions](int32 Value)
+		{
+			Futures.Add(SD::MakeReadyFuture<int32>(int32(Value))
+				.Then([](int32 Result)
+				{
+					return Result + 1;
+				}, ThreadPoolOptions));
+		});
+
+		SD::WhenAll(Futures).Then([this, Done](SD::TExpected<TArray<int32>> Expected)
+		{
+			TestTrue("All continuations completed", Expected.IsCompleted());
+			Done.Execute();
+		});
+	});
+}
+
+#endif //WITH_DEV_AUTOMATION_TESTS
@@ -0,0 +1,576 @@
+// Copyright 2020 Splash Damage, Ltd. - All Rights Reserved.
+
+#include <CoreMinimal.h>
+#include <FutureExtensions.h>
+
+#include "Helpers/TestHelpers.h"
+
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+/************************************************************************/
+/* FUTURE STREAMS SPEC                                                  */
+/************************************************************************/
+
+class FFutureTestSpec_Streams : public FFutureTestSpec
+{
+	GENERATE_SPEC(FFutureTestSpec_Streams, "FutureExtensions.Streams",
+		EAutomationTestFlags::ProductFilter |
+		EAutomationTestFlags::EditorContext |
+		EAutomationTestFlags::ServerContext
+	);
+
+	FFutureTestSpec_Streams() : FFutureTestSpec()
+	{
+		DefaultTimeout = FTimespan::FromSeconds(0.2);
+	}
+
+	static constexpr int32 ErrorCode = 0xdeadbeef;
+
+	//Reads every value that is ready, stopping at the first one that is not
+	template<typename T>
+	static TArray<T> ReadReady(const SD::TExpectedStream<T>& Stream, bool& bOutEnded)
+	{
+		TArray<T> Values;
+		bOutEnded = false;
+		while (true)
+		{
+			SD::TExpectedFuture<TOptional<T>> Next = Stream.Next();
+			if (!Next.IsReady() || !Next.Get().IsCompleted())
+			{
+				return Values;
+			}
+			if (!(*Next.Get()).IsSet())
+			{
+				bOutEnded = true;
+				return Values;
+			}
+			Values.Add((*Next.Get()).GetValue());
+		}
+	}
+
+	//Writes values until one has to wait, then carries on once it completes rather than blocking
+	static void WriteFrom(const SD::TExpectedStreamWriter<int32>& Writer, int32 Value, const int32 End)
+	{
+		for (; Value < End; ++Value)
+		{
+			SD::TExpectedFuture<void> Written = Writer.Write(Value);
+			if (!Written.IsReady())
+			{
+				Written.Then([Writer, Value, End]()
+				{
+					WriteFrom(Writer, Value + 1, End);
+				}, SD::FExpectedFutureOptions(SD::EExpectedFutureExecutionPolicy::ThreadPool));
+				return;
+			}
+		}
+		Writer.Close();
+	}
+
+	//Reads values until one has to wait, then carries on once it completes rather than blocking
+	static void ReadAll(const SD::TExpectedStream<int32>& Stream, TArray<int32>&& Values, TFunction<void(const TArray<int32>&)>&& OnEnded)
+	{
+		while (true)
+		{
+			SD::TExpectedFuture<TOptional<int32>> Next = Stream.Next();
+			if (!Next.IsReady())
+			{
+				Next.Then([Stream, Values = MoveTemp(Values), OnEnded = MoveTemp(OnEnded)](const TOptional<int32>& Value) mutable
+				{
+					if (Value.IsSet())
+					{
+						Values.Add(Value.GetValue());
+						ReadAll(Stream, MoveTemp(Values), MoveTemp(OnEnded));
+					}
+					else
+					{
+						OnEnded(Values);
+					}
+				}, SD::FExpectedFutureOptions(SD::EExpectedFutureExecutionPolicy::Inline));
+				return;
+			}
+
+			if (!Next.Get().IsCompleted() || !(*Next.Get()).IsSet())
+			{
+				OnEnded(Values);
+				return;
+			}
+			Values.Add((*Next.Get()).GetValue());
+		}
+	}
+
+	//Senders and receivers that share a channel, each carrying on from a continuation whenever it has to wait
+	struct FChannelPipe
+	{
+		explicit FChannelPipe(const int32 Capacity)
+			: Channel(Capacity)
+		{}
+
+		SD::TChannel<int32> Channel;
+		std::atomic<int32> NumSending{ 0 };
+		std::atomic<int32> NumReceiving{ 0 };
+
+		FCriticalSection CriticalSection;
+		TArray<int32> Received;
+		TFunction<void(const TArray<int32>&)> OnReceivedAll;
+	};
+	using FChannelPipeRef = TSharedRef<FChannelPipe, ESPMode::ThreadSafe>;
+
+	static void SendFrom(const FChannelPipeRef& Pipe, int32 Value, const int32 End)
+	{
+		const SD::FExpectedFutureOptions ThreadPool(SD::EExpectedFutureExecutionPolicy::ThreadPool);
+		for (; Value < End; ++Value)
+		{
+			SD::TExpectedFuture<void> Sent = Pipe->Channel.Send(Value, ThreadPool);
+			if (!Sent.IsReady())
+			{
+				Sent.Then([Pipe, Value, End]()
+				{
+					SendFrom(Pipe, Value + 1, End);
+				}, SD::FExpectedFutureOptions(SD::EExpectedFutureExecutionPolicy::Inline));
+				return;
+			}
+		}
+
+		if (Pipe->NumSending.fetch_sub(1) == 1)
+		{
+			Pipe->Channel.Close();
+		}
+	}
+
+	static void ReceiveFrom(const FChannelPipeRef& Pipe)
+	{
+		const SD::FExpectedFutureOptions ThreadPool(SD::EExpectedFutureExecutionPolicy::ThreadPool);
+		while (true)
+		{
+			SD::TExpectedFuture<int32> Next = Pipe->Channel.Receive(ThreadPool);
+			if (!Next.IsReady())
+			{
+				Next.Then([Pipe](const SD::TExpected<int32>& Value)
+				{
+					if (OnReceived(Pipe, Value))
+					{
+						ReceiveFrom(Pipe);
+					}
+				}, SD::FExpectedFutureOptions(SD::EExpectedFutureExecutionPolicy::Inline));
+				return;
+			}
+			if (!OnReceived(Pipe, Next.Get()))
+			{
+				return;
+			}
+		}
+	}
+
+	static bool OnReceived(const FChannelPipeRef& Pipe, const SD::TExpected<int32>& Value)
+	{
+		if (Value.IsCompleted())
+		{
+			FScopeLock Lock(&Pipe->CriticalSection);
+			Pipe->Received.Add(*Value);
+			return true;
+		}
+
+		if (Pipe->NumReceiving.fetch_sub(1) == 1)
+		{
+			Pipe->OnReceivedAll(Pipe->Received);
+		}
+		return false;
+	}
+};
+
+
+void FFutureTestSpec_Streams::Define()
+{
+	Describe("Stream", [this]()
+	{
+		LatentIt("Delivers values in order, then the end of the stream", [this](const auto& Done)
+		{
+			const SD::TExpectedStream<int32> Stream = SD::MakeStream<int32>(4, [](const SD::TExpectedStreamWriter<int32>& Writer)
+			{
+				for (int32 Value = 1; Value <= 3; ++Value)
+				{
+					Writer.Write(Value);
+				}
+				Writer.Close();
+			});
+
+			bool bEnded = false;
+			TestEqual("Values", ReadReady(Stream, bEnded), TArray<int32>({ 1, 2, 3 }));
+			TestTrue("Ended", bEnded);
+			Done.Execute();
+		});
+
+		LatentIt("Completes a waiting Next once a value is written", [this](const auto& Done)
+		{
+			TOptional<SD::TExpectedStreamWriter<int32>> Writer;
+			const SD::TExpectedStream<int32> Stream = SD::MakeStream<int32>(1, [&Writer](const SD::TExpectedStreamWriter<int32>& InWriter)
+			{
+				Writer.Emplace(InWriter);
+			});
+
+			SD::TExpectedFuture<TOptional<int32>> Next = Stream.Next();
+			TestFalse("Waits for a value", Next.IsReady());
+
+			Writer.GetValue().Write(7);
+			TestTrue("Next is ready", Next.IsReady() && *Next.Get() == TOptional<int32>(7));
+			Done.Execute();
+		});
+
+		LatentIt("Holds back the producer while the buffer is full", [this](const auto& Done)
+		{
+			TArray<SD::TExpectedFuture<void>> Writes;
+			const SD::TExpectedStream<int32> Stream = SD::MakeStream<int32>(2, [&Writes](const SD::TExpectedStreamWriter<int32>& Writer)
+			{
+				for (int32 Value = 0; Value < 4; ++Value)
+				{
+					Writes.Add(Writer.Write(Value));
+				}
+				Writer.Close();
+			});
+
+			TestTrue("Buffered writes are ready", Writes[0].IsReady() && Writes[1].IsReady());
+			TestFalse("Writes beyond the capacity wait", Writes[2].IsReady() || Writes[3].IsReady());
+
+			Stream.Next();
+			TestTrue("Oldest waiting write completes once there is room", Writes[2].IsReady());
+			TestFalse("Later write still waits", Writes[3].IsReady());
+
+			bool bEnded = false;
+			TestEqual("Values", ReadReady(Stream, bEnded), TArray<int32>({ 1, 2, 3 }));
+			TestTrue("Ended after the held back values", bEnded);
+			TestTrue("Every write completed", Writes[3].IsReady() && Writes[3].Get().IsCompleted());
+			Done.Execute();
+		});
+
+		LatentIt("Passes on the error once buffered values are read", [this](const auto& Done)
+		{
+			const SD::TExpectedStream<int32> Stream = SD::MakeStream<int32>(4, [](const SD::TExpectedStreamWriter<int32>& Writer)
+			{
+				Writer.Write(1);
+				Writer.Fail(SD::Error(ErrorCode));
+			});
+
+			TestEqual("Buffered value", *Stream.Next().Get(), TOptional<int32>(1));
+
+			SD::TExpectedFuture<TOptional<int32>> Failed = Stream.Next();
+			TestTrue("Failed", Failed.IsReady() && Failed.Get().IsError());
+			TestEqual("Error Code", Failed.Get().GetError()->GetErrorCode(), ErrorCode);
+			Done.Execute();
+		});
+
+		LatentIt("Cancels the producer through the cancellation handle", [this](const auto& Done)
+		{
+			const SD::SharedCancellationHandleRef CancellationHandle = SD::CreateCancellationHandle();
+			TOptional<SD::TExpectedStreamWriter<int32>> Writer;
+			const SD::TExpectedStream<int32> Stream = SD::MakeStream<int32>(1, [&Writer](const SD::TExpectedStreamWriter<int32>& InWriter)
+			{
+				Writer.Emplace(InWriter);
+			}, SD::FExpectedFutureOptions(CancellationHandle));
+
+			Writer.GetValue().Write(1);
+			SD::TExpectedFuture<void> Blocked = Writer.GetValue().Write(2);
+
+			CancellationHandle->Cancel();
+
+			TestTrue("Writer is cancelled", Writer.GetValue().IsCancelled());
+			TestTrue("Blocked write is cancelled", Blocked.IsReady() && Blocked.Get().IsCancelled());
+			TestTrue("Next is cancelled", Stream.Next().Get().IsCancelled());
+			Done.Execute();
+		});
+
+		LatentIt("Cancels the stream once the consumer drops it", [this](const auto& Done)
+		{
+			TOptional<SD::TExpectedStreamWriter<int32>> Writer;
+			SD::TExpectedFuture<TOptional<int32>> Next;
+			{
+				const SD::TExpectedStream<int32> Stream = SD::MakeStream<int32>(1, [&Writer](const SD::TExpectedStreamWriter<int32>& InWriter)
+				{
+					Writer.Emplace(InWriter);
+				});
+				Next = Stream.Next();
+			}
+
+			TestTrue("Writer is cancelled", Writer.GetValue().IsCancelled());
+			TestTrue("Waiting Next is cancelled", Next.IsReady() && Next.Get().IsCancelled());
+			TestTrue("Write is cancelled", Writer.GetValue().Write(1).Get().IsCancelled());
+			Done.Execute();
+		});
+
+		LatentIt("Streams from another thread", FTimespan::FromSeconds(10.0), [this](const auto& Done)
+		{
+			constexpr int32 NumValues = 1000;
+
+			const SD::TExpectedStream<int32> Stream = SD::MakeStream<int32>(8, [](const SD::TExpectedStreamWriter<int32>& Writer)
+			{
+				SD::Async([Writer]()
+				{
+					WriteFrom(Writer, 0, NumValues);
+				}, SD::FExpectedFutureOptions(SD::EExpectedFutureExecutionPolicy::ThreadPool));
+			});
+
+			ReadAll(Stream, TArray<int32>(), [this, Done](const TArray<int32>& Values)
+			{
+				bool bInOrder = Values.Num() == NumValues;
+				for (int32 Index = 0; bInOrder && Index < Values.Num(); ++Index)
+				{
+					bInOrder = Values[Index] == Index;
+				}
+
+				TestTrue("Every value in order", bInOrder);
+				Done.Execute();
+			});
+		});
+	});
+
+	Describe("Stream Operators", [this]()
+	{
+		LatentIt("Maps and filters values as they are read", [this](const auto& Done)
+		{
+			const SD::TExpectedStream<FString> Stream = SD::MakeStream<int32>(8, [](const SD::TExpectedStreamWriter<int32>& Writer)
+			{
+				for (int32 Value = 1; Value <= 6; ++Value)
+				{
+					Writer.Write(Value);
+				}
+				Writer.Close();
+			})
+			.Filter([](const int32 Value) { return Value % 2 == 0; })
+			.Map([](const int32 Value) { return FString::FromInt(Value * 10); });
+
+			bool bEnded = false;
+			TestEqual("Values", ReadReady(Stream, bEnded), TArray<FString>({ TEXT("20"), TEXT("40"), TEXT("60") }));
+			TestTrue("Ended", bEnded);
+			Done.Execute();
+		});
+
+		LatentIt("Waits through filtered out values", [this](const auto& Done)
+		{
+			TOptional<SD::TExpectedStreamWriter<int32>> Writer;
+			const SD::TExpectedStream<int32> Stream = SD::MakeStream<int32>(4, [&Writer](const SD::TExpectedStreamWriter<int32>& InWriter)
+			{
+				Writer.Emplace(InWriter);
+			})
+			.Filter([](const int32 Value) { return Value > 2; });
+
+			SD::TExpectedFuture<TOptional<int32>> Next = Stream.Next();
+			Writer.GetValue().Write(1);
+			Writer.GetValue().Write(2);
+			TestFalse("Still waiting", Next.IsReady());
+
+			Writer.GetValue().Write(3);
+			TestTrue("Next is ready", Next.IsReady() && *Next.Get() == TOptional<int32>(3));
+			Done.Execute();
+		});
+
+		LatentIt("Batches values, passing on a partial batch at the end", [this](const auto& Done)
+		{
+			const SD::TExpectedStream<TArray<int32>> Stream = SD::MakeStream<int32>(8, [](const SD::TExpectedStreamWriter<int32>& Writer)
+			{
+				for (int32 Value = 1; Value <= 5; ++Value)
+				{
+					Writer.Write(Value);
+				}
+				Writer.Close();
+			})
+			.Batch(2);
+
+			bool bEnded = false;
+			const TArray<TArray<int32>> Batches = ReadReady(Stream, bEnded);
+			TestEqual("Num Batches", Batches.Num(), 3);
+			if (Batches.Num() == 3)
+			{
+				TestEqual("First", Batches[0], TArray<int32>({ 1, 2 }));
+				TestEqual("Second", Batches[1], TArray<int32>({ 3, 4 }));
+				TestEqual("Partial", Batches[2], TArray<int32>({ 5 }));
+			}
+			TestTrue("Ended", bEnded);
+			Done.Execute();
+		});
+
+		LatentIt("Passes errors through operators", [this](const auto& Done)
+		{
+			const SD::TExpectedStream<TArray<int32>> Stream = SD::MakeStream<int32>(4, [](const SD::TExpectedStreamWriter<int32>& Writer)
+			{
+				Writer.Write(1);
+				Writer.Fail(SD::Error(ErrorCode));
+			})
+			.Map([](const int32 Value) { return Value + 1; })
+			.Batch(4);
+
+			SD::TExpectedFuture<TOptional<TArray<int32>>> Failed = Stream.Next();
+			TestTrue("Failed", Failed.IsReady() && Failed.Get().IsError());
+			TestEqual("Error Code", Failed.Get().GetError()->GetErrorCode(), ErrorCode);
+			Done.Execute();
+		});
+	});
+
+	Describe("Channel", [this]()
+	{
+		LatentIt("Receives values in the order they were sent", [this](const auto& Done)
+		{
+			SD::TChannel<int32> Channel(4);
+			TestTrue("Send is ready", Channel.Send(1).IsReady());
+			Channel.Send(2);
+
+			SD::TExpectedFuture<int32> First = Channel.Receive();
+			SD::TExpectedFuture<int32> Second = Channel.Receive();
+			TestTrue("First is ready", First.IsReady() && *First.Get() == 1);
+			TestTrue("Second is ready", Second.IsReady() && *Second.Get() == 2);
+			Done.Execute();
+		});
+
+		LatentIt("Completes a waiting Receive once a value is sent", [this](const auto& Done)
+		{
+			SD::TChannel<int32> Channel(1);
+			SD::TExpectedFuture<int32> Received = Channel.Receive(SD::FExpectedFutureOptions(SD::EExpectedFutureExecutionPolicy::Inline));
+			TestFalse("Waits for a value", Received.IsReady());
+
+			Channel.Send(5);
+			TestTrue("Received", Received.IsReady() && *Received.Get() == 5);
+			Done.Execute();
+		});
+
+		LatentIt("Completes a waiting Send once there is room", [this](const auto& Done)
+		{
+			SD::TChannel<int32> Channel(1);
+			Channel.Send(1);
+			SD::TExpectedFuture<void> Blocked = Channel.Send(2, SD::FExpectedFutureOptions(SD::EExpectedFutureExecutionPolicy::Inline));
+			TestFalse("Waits for room", Blocked.IsReady());
+
+			TestEqual("First", *Channel.Receive().Get(), 1);
+			TestTrue("Send completes", Blocked.IsReady() && Blocked.Get().IsCompleted());
+			TestEqual("Second", *Channel.Receive().Get(), 2);
+			Done.Execute();
+		});
+
+		LatentIt("Wakes a waiting Receive on the thread its options ask for", [this](const auto& Done)
+		{
+			SD::TChannel<int32> Channel(1);
+			const uint32 SendingThreadId = FPlatformTLS::GetCurrentThreadId();
+
+			Channel.Receive(SD::FExpectedFutureOptions(SD::EExpectedFutureExecutionPolicy::ThreadPool))
+				.Then([this, Done, SendingThreadId](const int32 Value)
+				{
+					TestEqual("Value", Value, 3);
+					TestNotEqual("Woken on another thread", FPlatformTLS::GetCurrentThreadId(), SendingThreadId);
+					Done.Execute();
+				}, SD::FExpectedFutureOptions(SD::EExpectedFutureExecutionPolicy::Inline));
+
+			Channel.Send(3);
+		});
+
+		LatentIt("Cancels waiting and later calls once closed", [this](const auto& Done)
+		{
+			SD::TChannel<int32> Channel(1);
+			Channel.Send(1);
+			SD::TExpectedFuture<void> Blocked = Channel.Send(2, SD::FExpectedFutureOptions(SD::EExpectedFutureExecutionPolicy::Inline));
+
+			Channel.Close();
+
+			TestTrue("Waiting Send is cancelled", Blocked.IsReady() && Blocked.Get().IsCancelled());
+			TestTrue("Later Send is cancelled", Channel.Send(3).Get().IsCancelled());
+			TestEqual("Values already sent are still received", *Channel.Receive().Get(), 1);
+			TestTrue("Receive is cancelled once empty", Channel.Receive().Get().IsCancelled());
+			Done.Execute();
+		});
+
+		LatentIt("Takes a cancelled Receive out of the queue", [this](const auto& Done)
+		{
+			SD::TChannel<int32> Channel(1);
+			const SD::SharedCancellationHandleRef CancellationHandle = SD::CreateCancellationHandle();
+
+			SD::TExpectedFuture<int32> Cancelled = Channel.Receive(SD::FExpectedFutureOptionsBuilder()
+				.SetExecutionPolicy(SD::EExpectedFutureExecutionPolicy::Inline)
+				.SetCancellationTokenHandle(CancellationHandle)
+				.Build());
+			SD::TExpectedFuture<int32> Waiting = Channel.Receive(SD::FExpectedFutureOptions(SD::EExpectedFutureExecutionPolicy::Inline));
+
+			CancellationHandle->Cancel();
+			Channel.Send(4);
+
+			TestTrue("Cancelled", Cancelled.IsReady() && Cancelled.Get().IsCancelled());
+			TestTrue("Next Receive gets the value", Waiting.IsReady() && *Waiting.Get() == 4);
+			Done.Execute();
+		});
+
+		LatentIt("Keeps the order of values sent past its capacity", FTimespan::FromSeconds(10.0), [this](const auto& Done)
+		{
+			constexpr int32 NumValues = 20000;
+
+			const FChannelPipeRef Pipe = MakeShared<FChannelPipe, ESPMode::ThreadSafe>(4);
+			Pipe->NumReceiving = 1;
+			Pipe->OnReceivedAll = [this, Done](const TArray<int32>& Received)
+			{
+				bool bInOrder = Received.Num() == NumValues;
+				for (int32 Index = 0; bInOrder && Index < Received.Num(); ++Index)
+				{
+					bInOrder = Received[Index] == Index;
+				}
+				TestTrue("Values are received in the order they were sent", bInOrder);
+				Done.Execute();
+			};
+
+			SD::Async([Pipe]()
+			{
+				ReceiveFrom(Pipe);
+			}, SD::FExpectedFutureOptions(SD::EExpectedFutureExecutionPolicy::ThreadPool));
+
+			//Sends without waiting, so later sends keep arriving while earlier ones are queued for room
+			SD::Async([Pipe]()
+			{
+				TArray<SD::TExpectedFuture<void>> Sent;
+				for (int32 Value = 0; Value < NumValues; ++Value)
+				{
+					Sent.Add(Pipe->Channel.Send(Value, SD::FExpectedFutureOptions(SD::EExpectedFutureExecutionPolicy::Inline)));
+				}
+
+				SD::WhenAll(Sent).Then([Pipe]()
+				{
+					Pipe->Channel.Close();
+				});
+			}, SD::FExpectedFutureOptions(SD::EExpectedFutureExecutionPolicy::ThreadPool));
+		});
+
+		LatentIt("Passes every value once between many senders and receivers", FTimespan::FromSeconds(10.0), [this](const auto& Done)
+		{
+			constexpr int32 NumSenders = 4;
+			constexpr int32 NumReceivers = 4;
+			constexpr int32 NumValuesPerSender = 2000;
+
+			const FChannelPipeRef Pipe = MakeShared<FChannelPipe, ESPMode::ThreadSafe>(8);
+			Pipe->NumSending = NumSenders;
+			Pipe->NumReceiving = NumReceivers;
+			Pipe->OnReceivedAll = [this, Done](const TArray<int32>& Received)
+			{
+				TArray<int32> Sorted = Received;
+				Sorted.Sort();
+
+				bool bEachOnce = Sorted.Num() == NumSenders * NumValuesPerSender;
+				for (int32 Index = 0; bEachOnce && Index < Sorted.Num(); ++Index)
+				{
+					bEachOnce = Sorted[Index] == Index;
+				}
+				TestTrue("Every value is received once", bEachOnce);
+				Done.Execute();
+			};
+
+			for (int32 Receiver = 0; Receiver < NumReceivers; ++Receiver)
+			{
+				SD::Async([Pipe]()
+				{
+					ReceiveFrom(Pipe);
+				}, SD::FExpectedFutureOptions(SD::EExpectedFutureExecutionPolicy::ThreadPool));
+			}
+			for (int32 Sender = 0; Sender < NumSenders; ++Sender)
+			{
+				SD::Async([Pipe, Sender]()
+				{
+					SendFrom(Pipe, Sender * NumValuesPerSender, (Sender + 1) * NumValuesPerSender);
+				}, SD::FExpectedFutureOptions(SD::EExpectedFutureExecutionPolicy::ThreadPool));
+			}
+		});
+	});
+}
+
+#endif //WITH_DEV_AUTOMATION_TESTS